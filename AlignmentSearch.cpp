@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include "AlignmentSearch.h"
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	const double STEPS_PER_PERIOD = 32; // of the shortest period, for the default step
+	const double DEFAULT_STEP = 24; // hours, when no body revolves
+	const double TOLERANCE = 1e-4; // hours
+	const int MAX_ITERATIONS = 100;
+
+	double apparentRadius(double radius, double distance)
+	{
+		return radius < distance ? asin(radius / distance) : PI / 2;
+	}
+}
+
+AlignmentSearch::AlignmentSearch(const BodyStore &source, int observerBody, const std::vector<int> &targetBodies)
+	: sourceTargets(targetBodies)
+{
+	std::vector<int> bodies(targetBodies), selected;
+	bodies.push_back(observerBody);
+	store = BodyStore::subset(source, bodies, selected);
+	observer = selected.back();
+	targets.assign(selected.begin(), selected.end() - 1);
+	for (int a = 0; a < (int)targets.size(); ++a)
+		for (int b = a + 1; b < (int)targets.size(); ++b)
+		{
+			pairA.push_back(a);
+			pairB.push_back(b);
+		}
+
+	double shortest = 0;
+	for (int i = 0; i != store.size(); ++i)
+		if (store.hoursOfRevolution[i] > 0 && (shortest == 0 || store.hoursOfRevolution[i] < shortest))
+			shortest = store.hoursOfRevolution[i];
+	step = shortest > 0 ? shortest / STEPS_PER_PERIOD : DEFAULT_STEP;
+}
+
+void AlignmentSearch::evaluate(Window &window, double hours) const
+{
+	BodyStore &s = window.store;
+	s.setEpoch(hours);
+	s.updateWorld();
+	++window.evaluations;
+	// ecliptic longitude is atan2(x, z) in scene axes
+	for (size_t p = 0; p != pairA.size(); ++p)
+	{
+		int a = targets[pairA[p]], b = targets[pairB[p]];
+		double ax = s.worldX[a] - s.worldX[observer], az = s.worldZ[a] - s.worldZ[observer];
+		double bx = s.worldX[b] - s.worldX[observer], bz = s.worldZ[b] - s.worldZ[observer];
+		double length = sqrt((ax * ax + az * az) * (bx * bx + bz * bz));
+		if (length == 0)
+			length = 1;
+		window.sine[p] = (bx * az - bz * ax) / length;
+		window.cosine[p] = (ax * bx + az * bz) / length;
+	}
+}
+
+double AlignmentSearch::refine(Window &window, int p, double t0, double s0, double t1, double s1) const
+{
+	// false position; the Illinois variant halves the value kept at an end
+	// that stays put, so both ends close in
+	int side = 0;
+	double t = t0;
+	for (int iteration = 0; iteration != MAX_ITERATIONS; ++iteration)
+	{
+		double previous = t;
+		t = t1 - s1 * (t1 - t0) / (s1 - s0);
+		if (!(t > t0 && t < t1))
+			t = 0.5 * (t0 + t1);
+		if (fabs(t - previous) < TOLERANCE || t1 - t0 < TOLERANCE)
+			break;
+		evaluate(window, t);
+		double s = window.sine[p];
+		if (s == 0)
+			break;
+		if ((s < 0) == (s1 < 0))
+		{
+			t1 = t;
+			s1 = s;
+			if (side == 1)
+				s0 *= 0.5;
+			side = 1;
+		}
+		else
+		{
+			t0 = t;
+			s0 = s;
+			if (side == -1)
+				s1 *= 0.5;
+			side = -1;
+		}
+	}
+	return t;
+}
+
+void AlignmentSearch::describe(Window &window, int p, double hours, Event &event) const
+{
+	evaluate(window, hours);
+	BodyStore &s = window.store;
+	int a = targets[pairA[p]], b = targets[pairB[p]];
+	double ax = s.worldX[a] - s.worldX[observer], ay = s.worldY[a] - s.worldY[observer], az = s.worldZ[a] - s.worldZ[observer];
+	double bx = s.worldX[b] - s.worldX[observer], by = s.worldY[b] - s.worldY[observer], bz = s.worldZ[b] - s.worldZ[observer];
+	double da = sqrt(ax * ax + ay * ay + az * az), db = sqrt(bx * bx + by * by + bz * bz);
+	double cosine = da > 0 && db > 0 ? (ax * bx + ay * by + az * bz) / (da * db) : 1;
+	double separation = acos(cosine > 1 ? 1 : (cosine < -1 ? -1 : cosine));
+
+	event.hours = hours;
+	event.kind = window.cosine[p] >= 0 ? CONJUNCTION : OPPOSITION;
+	event.a = sourceTargets[pairA[p]];
+	event.b = sourceTargets[pairB[p]];
+	event.separation = separation * 180.0 / PI;
+	double ra = BodyStore::rescaleKm(s.radius[a]), rb = BodyStore::rescaleKm(s.radius[b]);
+	double ro = BodyStore::rescaleKm(s.radius[observer]);
+	if (event.kind == CONJUNCTION)
+	{
+		// from somewhere on the observer the nearer body shifts by its parallax, less the farther one's
+		double parallax = fabs(apparentRadius(ro, da) - apparentRadius(ro, db));
+		event.eclipse = separation < apparentRadius(ra, da) + apparentRadius(rb, db) + parallax;
+	}
+	else if (s.parent[a] < 0)
+	{
+		// a is the star; the umbra at b's distance, from the parallaxes of a and b and the size of a
+		double umbra = apparentRadius(ro, db) + apparentRadius(ro, da) - apparentRadius(ra, da);
+		event.eclipse = umbra > 0 && PI - separation < umbra + apparentRadius(rb, db);
+	}
+	else
+		event.eclipse = false;
+}
+
+void AlignmentSearch::scan(Window &window, double start, double end, long long first, long long count,
+	std::vector<Event> &events) const
+{
+	size_t pairs = pairA.size();
+	std::vector<double> s0(pairs), s1(pairs);
+	double t0 = std::min(start + first * step, end); // no accumulated rounding
+	evaluate(window, t0);
+	s0 = window.sine;
+	for (long long k = first + 1; k <= first + count; ++k)
+	{
+		double t1 = std::min(start + k * step, end);
+		evaluate(window, t1);
+		s1 = window.sine;
+		for (size_t p = 0; p != pairs; ++p)
+		{
+			if ((s0[p] < 0) == (s1[p] < 0))
+				continue;
+			Event event;
+			describe(window, (int)p, refine(window, (int)p, t0, s0[p], t1, s1[p]), event);
+			events.push_back(event);
+		}
+		t0 = t1;
+		std::swap(s0, s1);
+	}
+}
+
+void AlignmentSearch::search(double start, double end, ThreadPool &pool, std::vector<Event> &events)
+{
+	events.clear();
+	evaluations = 0;
+	if (!(end > start) || pairA.empty())
+		return;
+	long long steps = (long long)ceil((end - start) / step);
+	int windows = (int)((steps + windowSteps - 1) / windowSteps);
+	std::vector<std::vector<Event> > found(windows);
+	std::atomic<long long> total(0);
+	pool.parallelFor(windows, 1, [&](int begin, int finish) {
+		Window window;
+		window.store = store;
+		window.sine.resize(pairA.size());
+		window.cosine.resize(pairA.size());
+		window.evaluations = 0;
+		for (int w = begin; w != finish; ++w)
+		{
+			long long first = (long long)w * windowSteps;
+			scan(window, start, end, first, std::min((long long)windowSteps, steps - first), found[w]);
+		}
+		total += window.evaluations;
+	});
+	for (int w = 0; w != windows; ++w)
+		events.insert(events.end(), found[w].begin(), found[w].end());
+	// the pairs of one step come out in pair order
+	std::stable_sort(events.begin(), events.end(), [](const Event &x, const Event &y) { return x.hours < y.hours; });
+	evaluations = total;
+}
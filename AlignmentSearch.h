@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "BodyStore.h"
+#include "ThreadPool.h"
+
+// Finds when bodies line up as seen from an observer: conjunctions, where
+// two bodies have the same ecliptic longitude, and oppositions, where their
+// longitudes are 180 degrees apart. The range is cut into windows that the
+// pool scans in parallel from the closed form (BodyStore::setEpoch), one
+// step at a time; a step over which the sine of the longitude difference
+// changes sign brackets an event, and false position narrows it down to a
+// fraction of a second. The step has to be shorter than the time between two
+// events of a pair; by default it is a fraction of the shortest period among
+// the bodies.
+//
+// An event also tells whether something is eclipsed: at a conjunction the
+// discs overlap as seen from somewhere on the observer (an eclipse, transit
+// or occultation); at an opposition with the star (a root body) first, the
+// second body touches the umbra of the observer, as the Moon in a lunar
+// eclipse seen from the Earth.
+class AlignmentSearch
+{
+public:
+	enum Kind { CONJUNCTION, OPPOSITION };
+
+	struct Event
+	{
+		double hours;
+		int kind;
+		int a, b; // indices in the store given to the constructor, a before b in the targets
+		double separation; // degree, between the directions to a and b
+		bool eclipse;
+	};
+
+	// keeps a private copy of the observer, the targets and their parents
+	AlignmentSearch(const BodyStore &store, int observer, const std::vector<int> &targets);
+
+	void setStep(double hours) { step = hours > 0 ? hours : step; }
+	double getStep() const { return step; }
+	void setWindowSteps(int steps) { windowSteps = steps > 0 ? steps : 1; }
+	// events of every pair of targets from start to end, sorted by time
+	void search(double start, double end, ThreadPool &pool, std::vector<Event> &events);
+	// times the positions were computed in the last search
+	long long getEvaluations() const { return evaluations; }
+private:
+	// what one thread scans with
+	struct Window
+	{
+		BodyStore store;
+		std::vector<double> sine, cosine; // of the longitude difference per pair, at the last time
+		long long evaluations;
+	};
+
+	// positions at the time into the window's store, then the sine and cosine of every pair
+	void evaluate(Window &window, double hours) const;
+	// the time of a sign change of pair p between t0 and t1
+	double refine(Window &window, int p, double t0, double s0, double t1, double s1) const;
+	void describe(Window &window, int p, double hours, Event &event) const;
+	// steps first to first + count of the range
+	void scan(Window &window, double start, double end, long long first, long long count, std::vector<Event> &events) const;
+
+	BodyStore store;
+	int observer;
+	std::vector<int> targets; // into store
+	std::vector<int> sourceTargets; // into the store of the caller
+	std::vector<int> pairA, pairB; // indices into targets
+	double step;
+	int windowSteps = 256;
+	long long evaluations = 0;
+};
@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include <string.h>
+#include "Arena.h"
+
+void *Arena::allocate(size_t size, size_t align)
+{
+	size_t padding = (align - ((uintptr_t)current & (align - 1))) & (align - 1);
+	if (current == NULL || padding + size > left)
+	{
+		size_t n = size + align > blockSize ? size + align : blockSize;
+		current = new char[n];
+		blocks.push_back(current);
+		left = n;
+		bytesReserved += n;
+		padding = (align - ((uintptr_t)current & (align - 1))) & (align - 1);
+	}
+	void *p = current + padding;
+	current += padding + size;
+	left -= padding + size;
+	return p;
+}
+
+const char *Arena::copyString(const char *s, size_t length)
+{
+	char *p = (char *)allocate(length + 1, 1);
+	memcpy(p, s, length);
+	p[length] = 0;
+	return p;
+}
+
+void Arena::clear()
+{
+	for (size_t i = 0; i != blocks.size(); ++i)
+		delete[] blocks[i];
+	blocks.clear();
+	current = NULL;
+	left = 0;
+	bytesReserved = 0;
+}
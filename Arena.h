@@ -0,0 +1,27 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+
+// Bump allocator. Memory is handed out from large blocks and released all at
+// once, so loading many small records costs a few big allocations.
+class Arena
+{
+public:
+	Arena(size_t blockSize = 1 << 20) : blockSize(blockSize) {}
+	~Arena() { clear(); }
+
+	void *allocate(size_t size, size_t align = sizeof(void *));
+	template <typename T> T *allocateArray(size_t n) { return (T *)allocate(sizeof(T) * n, alignof(T)); }
+	// copies length characters and appends a terminating zero
+	const char *copyString(const char *s, size_t length);
+	void clear();
+	size_t getBytesReserved() const { return bytesReserved; }
+private:
+	Arena(const Arena &);
+	Arena &operator=(const Arena &);
+	std::vector<char *> blocks;
+	char *current = NULL;
+	size_t left = 0;
+	size_t blockSize;
+	size_t bytesReserved = 0;
+};
@@ -1,55 +1,38 @@
 #pragma once
 #include <math.h>
+#include "BodyStore.h"
 
-enum SolarSystem {
-	SUN, MERCURY, VENUS, EARTH, MARS, JUPITER, SATURN, URANUS, NEPTUNE,
-	MOON, 
-	NUM_ELEMENTS
-};
+// A view of one body in a BodyStore. All state lives in the store, so views
+// are cheap to create and copy.
 class AstronomicalObject
 {
 public:
-	AstronomicalObject(SolarSystem elementIndex, AstronomicalObject *revoluteObject);
-	~AstronomicalObject();
-	void setRotation(double angleRotation) { this->angleRotation = angleRotation; }
-	void setRevolution(double angleRevolution) { this->angleRevolution = angleRevolution; }
-	void setRealDistanceMode(bool realDistanceMode) { this->realDistanceMode = realDistanceMode; }
-	double getRadius() { return rescaleKm(radius); }
-	double getDistanceRevolution(); 
-	AstronomicalObject& getRevoluteObject() { return *pRevoluteObject; }
-	double getAngleRotation() { return angleRotation; }
-	double getRadianRotation() { return degree2radian(angleRotation); }
-	double getAngleRevolution() { return angleRevolution; }
-	double getRadianRevolution() { return degree2radian(angleRevolution); }
-	double getAngleAxialTilt() { return angleAxialTilt; }
-	double getHoursOfRotation() { return hoursOfRotation; }
-	double gethoursOfRevolution() { return hoursOfRevolution; }
-	double getDeltaAngleRotation() { if (hoursOfRotation != 0) return (timeScale / hoursOfRotation); else return 0; }
-	double getDeltaAngleRevolution() { if (hoursOfRevolution) return (timeScale / hoursOfRevolution); else return 0; }
-	double getX();
-	double getY();
-	double getZ();
-	void increaseRotation();
-	void increaseRevolution();
+	AstronomicalObject(BodyStore &store, int index) : store(&store), index(index) {}
+	void setRotation(double angleRotation) { store->setRotation(index, angleRotation); }
+	void setRevolution(double angleRevolution) { store->setRevolution(index, angleRevolution); }
+	void setRealDistanceMode(bool realDistanceMode) { store->setRealDistanceMode(index, realDistanceMode); }
+	double getRadius() { return BodyStore::rescaleKm(store->radius[index]); }
+	double getDistanceRevolution() { return store->distance[index]; }
+	bool hasRevoluteObject() { return store->parent[index] >= 0; }
+	AstronomicalObject getRevoluteObject() { return AstronomicalObject(*store, store->parent[index]); }
+	double getAngleRotation() { return store->angleRotation[index]; }
+	double getRadianRotation() { return degree2radian(getAngleRotation()); }
+	double getAngleRevolution() { return store->angleRevolution[index]; }
+	double getRadianRevolution() { return degree2radian(getAngleRevolution()); }
+	double getAngleAxialTilt() { return store->angleAxialTilt[index]; }
+	double getHoursOfRotation() { return store->hoursOfRotation[index]; }
+	double gethoursOfRevolution() { return store->hoursOfRevolution[index]; }
+	double getDeltaAngleRotation() { return store->deltaRotation[index]; }
+	double getDeltaAngleRevolution() { return store->deltaRevolution[index]; }
+	int getIndex() { return index; }
+	double getX() { return store->getX(index); }
+	double getY() { return store->getY(index); }
+	double getZ() { return store->getZ(index); }
+	void increaseRotation() { store->increaseRotation(index); }
+	void increaseRevolution() { store->increaseRevolution(index); }
 private:
-	double radius; // km
-	double distanceRevolution; // km
-	double distanceRevolutionClose;
-	AstronomicalObject *pRevoluteObject;
-	double hoursOfRotation; // hours
-	double hoursOfRevolution; // hours
-	double angleAxialTilt; // degree
-	double angleRotation = 0; // degree
-	double angleRevolution = 0; // degree
-	double deltaRotation;
-	double deltaRevolution;
-	const double timeScale = 100.0; // big: fast, small: slow.
-	bool realDistanceMode = false;
-	// converting functions
-	double day2hour(double day) { return day * 24; }
-	double year2hour(double year) { return year * 356 * 24; }
-	double minute2hour(double minute) { return minute / 60.0; }
-	double rescaleKm(double kilometer) { return kilometer / 6378;  } // radius of the earth
+	BodyStore *store;
+	int index;
 	const double PI = 3.141593;
 	double degree2radian(double degree) { return PI / 180.0 * degree; }
-};
\ No newline at end of file
+};
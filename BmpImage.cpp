@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include "BmpImage.h"
+
+namespace
+{
+	unsigned read16(const unsigned char *p) { return p[0] | (p[1] << 8); }
+	unsigned read32(const unsigned char *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24); }
+}
+
+bool BmpImage::load(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		error = std::string(path) + ": cannot open";
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	file.resize(size > 0 ? size : 0);
+	bool ok = size > 0 && fread(&file[0], 1, size, f) == (size_t)size;
+	fclose(f);
+	if (!ok)
+	{
+		error = std::string(path) + ": read error";
+		return false;
+	}
+	if (!decode(&file[0], file.size()))
+	{
+		error = std::string(path) + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+bool BmpImage::decode(const unsigned char *data, size_t size)
+{
+	width = height = 0;
+	if (size < 54 || data[0] != 'B' || data[1] != 'M')
+	{
+		error = "not a bitmap";
+		return false;
+	}
+	size_t offset = read32(data + 10);
+	size_t headerSize = read32(data + 14);
+	int w = (int)read32(data + 18);
+	int h = (int)read32(data + 22);
+	unsigned bits = read16(data + 28);
+	unsigned compression = read32(data + 30);
+	unsigned colors = read32(data + 46);
+	bool topDown = h < 0;
+	if (topDown)
+		h = -h;
+	if (headerSize < 40 || w <= 0 || h <= 0 || (compression != 0 && !(compression == 3 && bits == 32)))
+	{
+		error = "unsupported bitmap";
+		return false;
+	}
+	if (bits != 8 && bits != 24 && bits != 32)
+	{
+		error = "unsupported bit depth";
+		return false;
+	}
+	size_t stride = ((size_t)w * bits / 8 + 3) & ~(size_t)3; // rows are padded to 4 bytes
+	if (offset > size || stride * h > size - offset)
+	{
+		error = "truncated bitmap";
+		return false;
+	}
+
+	const unsigned char *palette = NULL;
+	if (bits == 8)
+	{
+		if (colors == 0)
+			colors = 256;
+		// between the header and the pixels; checked as offsets, the pointer could overflow
+		if (offset < 14 || headerSize > offset - 14 || colors > (offset - 14 - headerSize) / 4)
+		{
+			error = "truncated palette";
+			return false;
+		}
+		palette = data + 14 + headerSize;
+	}
+
+	width = w;
+	height = h;
+	pixels.resize((size_t)w * h * 3);
+	for (int y = 0; y != h; ++y)
+	{
+		const unsigned char *src = data + offset + stride * (topDown ? h - 1 - y : y);
+		unsigned char *dst = &pixels[(size_t)w * 3 * y];
+		if (bits == 24)
+		{
+			for (int x = 0; x != w; ++x, src += 3, dst += 3)
+			{
+				dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+			}
+		}
+		else if (bits == 32)
+		{
+			for (int x = 0; x != w; ++x, src += 4, dst += 3)
+			{
+				dst[0] = src[2]; dst[1] = src[1]; dst[2] = src[0];
+			}
+		}
+		else
+		{
+			for (int x = 0; x != w; ++x, dst += 3)
+			{
+				unsigned index = src[x] < colors ? src[x] : 0;
+				const unsigned char *c = palette + 4 * index;
+				dst[0] = c[2]; dst[1] = c[1]; dst[2] = c[0];
+			}
+		}
+	}
+	return true;
+}
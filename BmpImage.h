@@ -0,0 +1,25 @@
+#pragma once
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Decoder for uncompressed Windows bitmaps (8-bit palette, 24-bit and 32-bit).
+// Pixels come out as tightly packed RGB rows, bottom row first, which is
+// what glTexImage2D expects with an unpack alignment of 1.
+class BmpImage
+{
+public:
+	bool load(const char *path);
+	bool decode(const unsigned char *data, size_t size);
+	const std::string &getError() const { return error; }
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	const unsigned char *getPixels() const { return pixels.empty() ? NULL : &pixels[0]; }
+private:
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> pixels;
+	std::vector<unsigned char> file; // reused between loads
+	std::string error;
+};
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unordered_map>
+#include "BodyCatalog.h"
+
+namespace
+{
+	const int NUM_FIELDS = 9;
+	const int MASS_FIELDS = 10; // with the optional mass
+	const int MAX_FIELDS = 15; // with the mass and all orbital elements
+	const int NUM_VALUES = 12; // numeric fields
+	const size_t READ_CHUNK = 64 * 1024;
+
+	size_t hashName(const char *s, size_t length)
+	{
+		size_t h = 2166136261u; // FNV-1a
+		for (size_t i = 0; i != length; ++i)
+			h = (h ^ (unsigned char)s[i]) * 16777619u;
+		return h;
+	}
+
+	bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	// splits a line into fields in place. returns the number of fields.
+	int split(char *line, char *end, char **fields, int maxFields)
+	{
+		int n = 0;
+		char *p = line;
+		while (p != end)
+		{
+			while (p != end && isBlank(*p))
+				++p;
+			if (p == end || *p == '#')
+				break;
+			if (n == maxFields)
+				return maxFields + 1;
+			fields[n++] = p;
+			while (p != end && !isBlank(*p) && *p != '#')
+				++p;
+			if (p != end)
+			{
+				bool comment = (*p == '#');
+				*p++ = 0;
+				if (comment)
+					break;
+			}
+		}
+		return n;
+	}
+}
+
+bool BodyCatalog::load(const char *path, BodyStore &store)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		error = std::string("cannot open ") + path;
+		return false;
+	}
+	// in chunks until the end, so pipes work too
+	std::vector<char> text;
+	size_t read = 0;
+	for (;;)
+	{
+		text.resize(read + READ_CHUNK + 1);
+		size_t got = fread(&text[read], 1, READ_CHUNK, file);
+		read += got;
+		if (got < READ_CHUNK)
+			break;
+	}
+	bool failed = ferror(file) != 0;
+	fclose(file);
+	if (failed)
+	{
+		error = std::string("cannot read ") + path;
+		return false;
+	}
+	text[read] = 0;
+
+	if (!parse(&text[0], read, store))
+	{
+		error = std::string(path) + ":" + error;
+		return false;
+	}
+	return true;
+}
+
+// text[length] must be writable
+bool BodyCatalog::parse(char *text, size_t length, BodyStore &store)
+{
+	char *end = text + length;
+	if (store.size() != size())
+	{
+		error = " store holds bodies that are not in the catalog";
+		return false;
+	}
+
+	// size everything once up front
+	int lines = 1;
+	for (char *p = text; p != end; ++p)
+		if (*p == '\n')
+			++lines;
+	store.reserve(store.size() + lines);
+	names.reserve(names.size() + lines);
+	texture.reserve(texture.size() + lines);
+	size_t tableSize = 16;
+	while (tableSize < 2 * (names.size() + lines))
+		tableSize *= 2;
+	if (table.size() < tableSize)
+	{
+		table.assign(tableSize, -1);
+		for (int i = 0; i != (int)names.size(); ++i)
+			insert(i);
+	}
+
+	std::unordered_map<std::string, int> textureIndex;
+	for (int i = 0; i != (int)textureFiles.size(); ++i)
+		textureIndex[textureFiles[i]] = i;
+
+	int lineNumber = 0;
+	char *line = text;
+	while (line < end)
+	{
+		char *next = (char *)memchr(line, '\n', end - line);
+		if (next == NULL)
+			next = end;
+		*next = 0; // text holds one byte past the end
+		++lineNumber;
+
+		char *fields[MAX_FIELDS];
+		int n = split(line, next, fields, MAX_FIELDS);
+		line = next + 1;
+		if (n == 0)
+			continue;
+		// the orbital elements come all together; a short line is an error, not a zero
+		if (n != NUM_FIELDS && n != MASS_FIELDS && n != MAX_FIELDS)
+		{
+			char message[64];
+			sprintf(message, "%d: expected %d, %d or %d fields", lineNumber, NUM_FIELDS, MASS_FIELDS, MAX_FIELDS);
+			error = message;
+			return false;
+		}
+
+		// radius .. tilt, then mass and the orbital elements, 0 when left out
+		double values[NUM_VALUES] = { 0 };
+		for (int k = 0; k != NUM_VALUES; ++k)
+		{
+			int field = k < 6 ? 2 + k : 3 + k;
+			if (field >= n)
+				break;
+			char *stop;
+			values[k] = strtod(fields[field], &stop);
+			if (stop == fields[field] || *stop != 0)
+			{
+				char message[64];
+				sprintf(message, "%d: bad number in field %d", lineNumber, field + 1);
+				error = message;
+				return false;
+			}
+		}
+		if (values[7] < 0 || values[7] >= 1)
+		{
+			char message[64];
+			sprintf(message, "%d: eccentricity must be in [0, 1)", lineNumber);
+			error = message;
+			return false;
+		}
+
+		int parent = -1;
+		if (strcmp(fields[1], "-") != 0)
+		{
+			parent = lookup(fields[1], strlen(fields[1]));
+			if (parent < 0)
+			{
+				char message[64];
+				sprintf(message, "%d: unknown parent ", lineNumber);
+				error = std::string(message) + fields[1];
+				return false;
+			}
+		}
+		if (lookup(fields[0], strlen(fields[0])) >= 0)
+		{
+			char message[64];
+			sprintf(message, "%d: duplicate name ", lineNumber);
+			error = std::string(message) + fields[0];
+			return false;
+		}
+
+		int tex = -1;
+		if (strcmp(fields[8], "-") != 0)
+		{
+			std::unordered_map<std::string, int>::iterator it = textureIndex.find(fields[8]);
+			if (it == textureIndex.end())
+			{
+				tex = (int)textureFiles.size();
+				textureFiles.push_back(arena.copyString(fields[8], strlen(fields[8])));
+				textureIndex[fields[8]] = tex;
+			}
+			else
+				tex = it->second;
+		}
+
+		int i = store.add(values[0], values[1], values[2], values[3], values[4], values[5], parent, values[6]);
+		if (n > 10)
+			store.setOrbitElements(i, values[7], values[8], values[9], values[10], values[11]);
+		names.push_back(arena.copyString(fields[0], strlen(fields[0])));
+		texture.push_back(tex);
+		insert(i);
+	}
+	return true;
+}
+
+int BodyCatalog::find(const char *name) const
+{
+	return lookup(name, strlen(name));
+}
+
+int BodyCatalog::lookup(const char *name, size_t length) const
+{
+	if (table.empty())
+		return -1;
+	size_t mask = table.size() - 1;
+	for (size_t h = hashName(name, length) & mask; table[h] >= 0; h = (h + 1) & mask)
+	{
+		const char *s = names[table[h]];
+		if (strncmp(s, name, length) == 0 && s[length] == 0)
+			return table[h];
+	}
+	return -1;
+}
+
+void BodyCatalog::insert(int i)
+{
+	size_t mask = table.size() - 1;
+	size_t h = hashName(names[i], strlen(names[i])) & mask;
+	while (table[h] >= 0)
+		h = (h + 1) & mask;
+	table[h] = i;
+}
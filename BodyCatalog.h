@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Arena.h"
+#include "BodyStore.h"
+
+// Names and textures of the bodies in a BodyStore, loaded from a catalog file.
+//
+// One body per line, fields separated by spaces or tabs, '#' starts a comment:
+//   name parent radius(km) distance(km) distanceClose(km) rotation(hours) revolution(hours) tilt(degree) texture
+//   [mass(kg) [eccentricity inclination node periapsis meanAnomaly]]
+// parent and texture may be '-'. A body without mass is a test particle in
+// gravity mode. The optional Keplerian elements, all five or none, are in degrees except the
+// eccentricity; distance is then the semi-major axis. A parent must be listed before its children,
+// which keeps parent indices smaller than child indices in the store.
+class BodyCatalog
+{
+public:
+	// appends every body in the file to the store. returns false on error.
+	bool load(const char *path, BodyStore &store);
+	const std::string &getError() const { return error; }
+
+	int size() const { return (int)names.size(); }
+	// -1 if there is no body with the name
+	int find(const char *name) const;
+	const char *getName(int i) const { return names[i]; }
+	// index into getTextureFiles(), -1 for an untextured body
+	int getTexture(int i) const { return texture[i]; }
+	const std::vector<const char *> &getTextureFiles() const { return textureFiles; }
+private:
+	Arena arena; // all strings
+	std::vector<const char *> names;
+	std::vector<int> texture;
+	std::vector<const char *> textureFiles;
+	std::string error;
+
+	// open addressing hash table of body indices by name
+	std::vector<int> table;
+	int lookup(const char *name, size_t length) const;
+	void insert(int i);
+	bool parse(char *text, size_t length, BodyStore &store);
+};
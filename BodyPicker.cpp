@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <math.h>
+#include "BodyPicker.h"
+#include "FrustumCuller.h"
+
+namespace
+{
+	const int LEAF_SIZE = 8; // most leaves get 4 or 5 bodies
+	const double REBUILD_GROWTH = 2.0;
+	const int MAX_DEPTH = 64;
+
+	double surface(const double *low, const double *high)
+	{
+		double dx = high[0] - low[0], dy = high[1] - low[1], dz = high[2] - low[2];
+		return dx * dy + dy * dz + dz * dx;
+	}
+
+	// entry distance along the ray, or a negative value on a miss; inverse is 1 / direction
+	double enterBox(const double *low, const double *high, const double *origin, const double *inverse, double grow, double limit)
+	{
+		double near = 0, far = limit;
+		for (int a = 0; a != 3; ++a)
+		{
+			double t0 = (low[a] - grow - origin[a]) * inverse[a];
+			double t1 = (high[a] + grow - origin[a]) * inverse[a];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			near = t0 > near ? t0 : near;
+			far = t1 < far ? t1 : far;
+			if (near > far)
+				return -1;
+		}
+		return near;
+	}
+}
+
+void BodyPicker::refit(BodyStore &store)
+{
+	store.updateWorld();
+	if ((int)order.size() != store.size() || refitNodes(store) > REBUILD_GROWTH * builtSurface)
+		build(store);
+}
+
+void BodyPicker::build(const BodyStore &store)
+{
+	int n = store.size();
+	order.resize(n);
+	for (int i = 0; i != n; ++i)
+		order[i] = i;
+	nodes.clear();
+	if (n > 0)
+		buildNode(store, 0, n);
+	builtSurface = refitNodes(store);
+	++builds;
+}
+
+int BodyPicker::buildNode(const BodyStore &store, int first, int count)
+{
+	int index = (int)nodes.size();
+	nodes.push_back(Node());
+	if (count <= LEAF_SIZE)
+	{
+		nodes[index].first = first;
+		nodes[index].count = count;
+		return index;
+	}
+	// split at the median centre along the longest side of the centres' box
+	const std::vector<double> *centres[3] = { &store.worldX, &store.worldY, &store.worldZ };
+	double low[3], high[3];
+	for (int a = 0; a != 3; ++a)
+	{
+		low[a] = high[a] = (*centres[a])[order[first]];
+		for (int k = first + 1; k != first + count; ++k)
+		{
+			double c = (*centres[a])[order[k]];
+			low[a] = std::min(low[a], c);
+			high[a] = std::max(high[a], c);
+		}
+	}
+	int axis = 0;
+	for (int a = 1; a != 3; ++a)
+		if (high[a] - low[a] > high[axis] - low[axis])
+			axis = a;
+	const std::vector<double> &key = *centres[axis];
+	int half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+		[&key](int a, int b) { return key[a] < key[b]; });
+	buildNode(store, first, half);
+	int second = buildNode(store, first + half, count - half);
+	nodes[index].first = second;
+	nodes[index].count = 0;
+	return index;
+}
+
+double BodyPicker::refitNodes(const BodyStore &store)
+{
+	spheres.resize(order.size());
+	// children come after their parent, so backwards every child is done first
+	double total = 0;
+	for (int k = (int)nodes.size() - 1; k >= 0; --k)
+	{
+		Node &node = nodes[k];
+		if (node.count > 0)
+		{
+			// the spheres of a leaf are copied in leaf order as it is refit
+			double low[3] = { HUGE_VAL, HUGE_VAL, HUGE_VAL }, high[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+			for (int e = node.first; e != node.first + node.count; ++e)
+			{
+				int i = order[e];
+				Sphere &s = spheres[e];
+				s.x = store.worldX[i];
+				s.y = store.worldY[i];
+				s.z = store.worldZ[i];
+				s.radius = FrustumCuller::boundingRadius(store, i);
+				low[0] = std::min(low[0], s.x - s.radius); high[0] = std::max(high[0], s.x + s.radius);
+				low[1] = std::min(low[1], s.y - s.radius); high[1] = std::max(high[1], s.y + s.radius);
+				low[2] = std::min(low[2], s.z - s.radius); high[2] = std::max(high[2], s.z + s.radius);
+			}
+			for (int c = 0; c != 3; ++c)
+			{
+				node.low[c] = low[c];
+				node.high[c] = high[c];
+			}
+		}
+		else
+		{
+			const Node &a = nodes[k + 1], &b = nodes[node.first];
+			for (int c = 0; c != 3; ++c)
+			{
+				node.low[c] = std::min(a.low[c], b.low[c]);
+				node.high[c] = std::max(a.high[c], b.high[c]);
+			}
+		}
+		total += surface(node.low, node.high);
+	}
+	return total;
+}
+
+int BodyPicker::pick(const double *origin, const double *direction, double tolerance) const
+{
+	if (nodes.empty())
+		return -1;
+	double length = sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+	if (length == 0)
+		return -1;
+	double d[3] = { direction[0] / length, direction[1] / length, direction[2] / length };
+	double inverse[3];
+	for (int a = 0; a != 3; ++a)
+		inverse[a] = d[a] != 0 ? 1.0 / d[a] : HUGE_VAL;
+	double slope = tan(tolerance); // radius added per unit of distance
+
+	int best = -1;
+	double bestT = HUGE_VAL;
+	// nodes still to visit, with their entry distance
+	int stack[MAX_DEPTH * 2];
+	double stackT[MAX_DEPTH * 2];
+	int top = 0;
+	stack[top] = 0;
+	stackT[top++] = 0;
+	while (top > 0)
+	{
+		--top;
+		if (stackT[top] > bestT)
+			continue;
+		const Node &node = nodes[stack[top]];
+		if (node.count > 0)
+		{
+			for (int e = node.first; e != node.first + node.count; ++e)
+			{
+				const Sphere &s = spheres[e];
+				double cx = s.x - origin[0], cy = s.y - origin[1], cz = s.z - origin[2];
+				double along = cx * d[0] + cy * d[1] + cz * d[2];
+				if (along <= 0)
+					continue;
+				double off2 = cx * cx + cy * cy + cz * cz - along * along; // squared distance from the ray
+				double r = s.radius;
+				double hit;
+				if (off2 <= r * r)
+					hit = along - sqrt(r * r - off2); // on the sphere
+				else
+				{
+					double grown = r + slope * along;
+					if (off2 > grown * grown)
+						continue;
+					hit = along; // close enough to the ray
+				}
+				if (hit < bestT)
+				{
+					bestT = hit;
+					best = order[e];
+				}
+			}
+			continue;
+		}
+		// the boxes grow with the tolerance at their far side
+		int children[2] = { stack[top] + 1, node.first };
+		double t[2];
+		for (int c = 0; c != 2; ++c)
+		{
+			const Node &child = nodes[children[c]];
+			double farX = std::max(fabs(child.low[0] - origin[0]), fabs(child.high[0] - origin[0]));
+			double farY = std::max(fabs(child.low[1] - origin[1]), fabs(child.high[1] - origin[1]));
+			double farZ = std::max(fabs(child.low[2] - origin[2]), fabs(child.high[2] - origin[2]));
+			double grow = slope * sqrt(farX * farX + farY * farY + farZ * farZ);
+			t[c] = enterBox(child.low, child.high, origin, inverse, grow, bestT);
+		}
+		// the nearer child is visited first, so it goes on top
+		int nearer = t[1] >= 0 && (t[0] < 0 || t[1] < t[0]) ? 1 : 0;
+		for (int k = 0; k != 2; ++k)
+		{
+			int c = k == 0 ? 1 - nearer : nearer;
+			if (t[c] >= 0 && top < MAX_DEPTH * 2)
+			{
+				stack[top] = children[c];
+				stackT[top++] = t[c];
+			}
+		}
+	}
+	return best;
+}
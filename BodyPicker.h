@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include "BodyStore.h"
+
+// Finds the body under a ray, e.g. from the camera through the mouse.
+// The bounding spheres of the bodies (FrustumCuller::boundingRadius) sit in
+// a bounding volume hierarchy of axis-aligned boxes. The tree is built once
+// and refit to the new positions every tick, one pass from the leaves
+// up; moving bodies slowly loosen the boxes, and the tree is rebuilt once
+// their total surface is twice what it was after the last build. A ray
+// visits the nearer child first and skips every box behind the nearest hit
+// so far, so a pick visits a small part of the tree.
+class BodyPicker
+{
+public:
+	// to the world positions and radii of the store; builds the tree the first time
+	void refit(BodyStore &store);
+	// nearest body the ray hits, -1 if none. Bodies smaller than tolerance
+	// (radian, e.g. a few pixels) as seen from the origin count as that large.
+	int pick(const double *origin, const double *direction, double tolerance) const;
+
+	int getNodeCount() const { return (int)nodes.size(); }
+	long long getBuilds() const { return builds; }
+private:
+	struct Node
+	{
+		double low[3], high[3];
+		int first; // leaf: first entry in order; inner: index of the second child, the first follows the node
+		int count; // bodies in a leaf, 0 for an inner node
+	};
+
+	struct Sphere
+	{
+		double x, y, z, radius;
+	};
+
+	void build(const BodyStore &store);
+	int buildNode(const BodyStore &store, int first, int count);
+	double refitNodes(const BodyStore &store);
+
+	std::vector<Node> nodes; // depth first, children after their parent
+	std::vector<int> order; // bodies in leaf order
+	std::vector<Sphere> spheres; // in leaf order, at the last refit
+	double builtSurface = 0; // sum of the node surfaces after the last build
+	long long builds = 0;
+};
@@ -0,0 +1,322 @@
+#include <assert.h>
+#include <math.h>
+#include "BodyStore.h"
+#include "FastMath.h"
+#include "Kepler.h"
+
+int BodyStore::add(double radius, double distanceRevolution, double distanceRevolutionClose,
+	double hoursOfRotation, double hoursOfRevolution, double angleAxialTilt, int parent, double mass)
+{
+	int i = size();
+	assert(parent < i);
+	this->radius.push_back(radius);
+	this->mass.push_back(mass);
+	this->distanceRevolution.push_back(distanceRevolution);
+	this->distanceRevolutionClose.push_back(distanceRevolutionClose);
+	this->distance.push_back(0);
+	this->hoursOfRotation.push_back(hoursOfRotation);
+	this->hoursOfRevolution.push_back(hoursOfRevolution);
+	this->angleAxialTilt.push_back(angleAxialTilt);
+	this->angleRotation.push_back(0);
+	this->angleRevolution.push_back(0);
+	this->deltaRotation.push_back(hoursOfRotation != 0 ? timeScale / hoursOfRotation : 0);
+	this->deltaRevolution.push_back(hoursOfRevolution != 0 ? timeScale / hoursOfRevolution : 0);
+	this->rateRotation.push_back(hoursOfRotation != 0 ? 360.0 / hoursOfRotation : 0);
+	this->rateRevolution.push_back(hoursOfRevolution != 0 ? 360.0 / hoursOfRevolution : 0);
+	this->eccentricity.push_back(0);
+	this->orbitEccentricity.push_back(0);
+	this->inclination.push_back(0);
+	this->longitudeOfNode.push_back(0);
+	this->argumentOfPeriapsis.push_back(0);
+	this->meanAnomalyAtEpoch.push_back(0);
+	this->eccentricAnomaly.push_back(0);
+	this->orbitPX.push_back(0);
+	this->orbitPY.push_back(0);
+	this->orbitPZ.push_back(1);
+	this->orbitQX.push_back(1);
+	this->orbitQY.push_back(0);
+	this->orbitQZ.push_back(0);
+	this->localX.push_back(0);
+	this->localY.push_back(0);
+	this->localZ.push_back(0);
+	this->parent.push_back(parent);
+	this->realDistanceMode.push_back(false);
+	this->worldX.push_back(0);
+	this->worldY.push_back(0);
+	this->worldZ.push_back(0);
+	this->dirty.push_back(true);
+	worldDirty = true;
+	updateDistance(i);
+	return i;
+}
+
+BodyStore BodyStore::subset(const BodyStore &source, const std::vector<int> &bodies, std::vector<int> &selected)
+{
+	// a body needs its parents for a world position; keep only those
+	std::vector<char> keep(source.size(), false);
+	for (size_t k = 0; k != bodies.size(); ++k)
+		for (int i = bodies[k]; i >= 0 && !keep[i]; i = source.parent[i])
+			keep[i] = true;
+
+	// parents come first in the source, so they come first in the copy too
+	BodyStore store(source.getTimeScale());
+	std::vector<int> map(source.size(), -1);
+	for (int i = 0; i != source.size(); ++i)
+	{
+		if (!keep[i])
+			continue;
+		int p = source.parent[i];
+		int j = store.add(source.radius[i], source.distanceRevolution[i], source.distanceRevolutionClose[i],
+			source.hoursOfRotation[i], source.hoursOfRevolution[i], source.angleAxialTilt[i],
+			p >= 0 ? map[p] : -1, source.mass[i]);
+		store.setOrbitElements(j, source.eccentricity[i], source.inclination[i],
+			source.longitudeOfNode[i], source.argumentOfPeriapsis[i], source.meanAnomalyAtEpoch[i]);
+		store.setRealDistanceMode(j, source.realDistanceMode[i] != 0);
+		map[i] = j;
+	}
+	selected.clear();
+	for (size_t k = 0; k != bodies.size(); ++k)
+		selected.push_back(map[bodies[k]]);
+	return store;
+}
+
+void BodyStore::reserve(int n)
+{
+	radius.reserve(n);
+	mass.reserve(n);
+	distanceRevolution.reserve(n);
+	distanceRevolutionClose.reserve(n);
+	distance.reserve(n);
+	hoursOfRotation.reserve(n);
+	hoursOfRevolution.reserve(n);
+	angleAxialTilt.reserve(n);
+	angleRotation.reserve(n);
+	angleRevolution.reserve(n);
+	deltaRotation.reserve(n);
+	deltaRevolution.reserve(n);
+	rateRotation.reserve(n);
+	rateRevolution.reserve(n);
+	eccentricity.reserve(n);
+	orbitEccentricity.reserve(n);
+	inclination.reserve(n);
+	longitudeOfNode.reserve(n);
+	argumentOfPeriapsis.reserve(n);
+	meanAnomalyAtEpoch.reserve(n);
+	eccentricAnomaly.reserve(n);
+	orbitPX.reserve(n);
+	orbitPY.reserve(n);
+	orbitPZ.reserve(n);
+	orbitQX.reserve(n);
+	orbitQY.reserve(n);
+	orbitQZ.reserve(n);
+	localX.reserve(n);
+	localY.reserve(n);
+	localZ.reserve(n);
+	parent.reserve(n);
+	realDistanceMode.reserve(n);
+	worldX.reserve(n);
+	worldY.reserve(n);
+	worldZ.reserve(n);
+	dirty.reserve(n);
+}
+
+// angle[i] = wrap(angle[i]) + delta[i], branch-free so the compiler can vectorize it
+void BodyStore::wrapAdd(double *angle, const double *delta, int n)
+{
+	int i = 0;
+#ifdef FASTMATH_SSE2
+	const __m128d full = _mm_set1_pd(360.0);
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128d a = _mm_loadu_pd(angle + i);
+		a = _mm_sub_pd(a, _mm_and_pd(_mm_cmpgt_pd(a, full), full));
+		_mm_storeu_pd(angle + i, _mm_add_pd(a, _mm_loadu_pd(delta + i)));
+	}
+#endif
+	for (; i < n; ++i)
+	{
+		double a = angle[i];
+		angle[i] = (a > 360.0 ? a - 360.0 : a) + delta[i];
+	}
+}
+
+// angle[i] = (rate[i] * hours) mod 360
+void BodyStore::phase(double *angle, const double *rate, double hours, int n)
+{
+	for (int i = 0; i < n; ++i)
+	{
+		double a = rate[i] * hours;
+		angle[i] = a - 360.0 * floor(a * (1.0 / 360.0));
+	}
+}
+
+void BodyStore::advance()
+{
+	int n = size();
+	epoch += getHoursPerTick();
+	if (n == 0)
+		return;
+	wrapAdd(&angleRotation[0], &deltaRotation[0], n);
+	wrapAdd(&angleRevolution[0], &deltaRevolution[0], n);
+	updateOrbits();
+}
+
+void BodyStore::setEpoch(double hours)
+{
+	int n = size();
+	epoch = hours;
+	if (n == 0)
+		return;
+	phase(&angleRotation[0], &rateRotation[0], hours, n);
+	phase(&angleRevolution[0], &rateRevolution[0], hours, n);
+	updateOrbits();
+}
+
+// local positions of every body from its mean anomaly, in three batched passes
+void BodyStore::updateOrbits()
+{
+	int n = size();
+	scratch.resize(2 * n);
+	double *meanAnomaly = &scratch[0];
+	for (int i = 0; i < n; ++i)
+		meanAnomaly[i] = (angleRevolution[i] + meanAnomalyAtEpoch[i]) * FastMath::RADIAN_PER_DEGREE;
+	Kepler::solve(meanAnomaly, &orbitEccentricity[0], &eccentricAnomaly[0], n);
+
+	double *s = &scratch[0];
+	double *c = &scratch[n];
+	for (int i = 0; i < n; ++i)
+		s[i] = eccentricAnomaly[i] * (1.0 / FastMath::RADIAN_PER_DEGREE);
+	FastMath::sinCosDegree(s, s, c, n);
+	for (int i = 0; i < n; ++i)
+	{
+		double e = orbitEccentricity[i];
+		double xp = distance[i] * (c[i] - e);
+		double yp = distance[i] * sqrt(1.0 - e * e) * s[i];
+		localX[i] = xp * orbitPX[i] + yp * orbitQX[i];
+		localY[i] = xp * orbitPY[i] + yp * orbitQY[i];
+		localZ[i] = xp * orbitPZ[i] + yp * orbitQZ[i];
+	}
+	markAllDirty();
+}
+
+void BodyStore::updateOrbit(int i)
+{
+	double e = orbitEccentricity[i];
+	double E = Kepler::solve((angleRevolution[i] + meanAnomalyAtEpoch[i]) * FastMath::RADIAN_PER_DEGREE, e);
+	double s, c;
+	FastMath::sinCosDegree(E * (1.0 / FastMath::RADIAN_PER_DEGREE), s, c);
+	eccentricAnomaly[i] = E;
+	double xp = distance[i] * (c - e);
+	double yp = distance[i] * sqrt(1.0 - e * e) * s;
+	localX[i] = xp * orbitPX[i] + yp * orbitQX[i];
+	localY[i] = xp * orbitPY[i] + yp * orbitQY[i];
+	localZ[i] = xp * orbitPZ[i] + yp * orbitQZ[i];
+	markDirty(i);
+}
+
+void BodyStore::setOrbitElements(int i, double eccentricity, double inclination,
+	double longitudeOfNode, double argumentOfPeriapsis, double meanAnomalyAtEpoch)
+{
+	this->eccentricity[i] = eccentricity;
+	orbitEccentricity[i] = realDistanceMode[i] ? eccentricity : 0;
+	this->inclination[i] = inclination;
+	this->longitudeOfNode[i] = longitudeOfNode;
+	this->argumentOfPeriapsis[i] = argumentOfPeriapsis;
+	this->meanAnomalyAtEpoch[i] = meanAnomalyAtEpoch;
+
+	double si, ci, sn, cn, sw, cw;
+	FastMath::sinCosDegree(inclination, si, ci);
+	FastMath::sinCosDegree(longitudeOfNode, sn, cn);
+	FastMath::sinCosDegree(argumentOfPeriapsis, sw, cw);
+	// ecliptic x, y, z map to scene z, x, y so that a circular orbit
+	// with zero elements is (d sin M, 0, d cos M)
+	orbitPZ[i] = cn * cw - sn * sw * ci;
+	orbitPX[i] = sn * cw + cn * sw * ci;
+	orbitPY[i] = sw * si;
+	orbitQZ[i] = -cn * sw - sn * cw * ci;
+	orbitQX[i] = -sn * sw + cn * cw * ci;
+	orbitQY[i] = cw * si;
+	updateOrbit(i);
+}
+
+void BodyStore::updateWorld()
+{
+	if (!worldDirty)
+		return;
+	int n = size();
+	// a dirty parent makes its children dirty; parents come first
+	for (int i = 0; i != n; ++i)
+	{
+		int p = parent[i];
+		if (!allDirty && !dirty[i] && (p < 0 || !dirty[p]))
+			continue;
+		dirty[i] = true;
+		double px = 0, py = 0, pz = 0;
+		if (p >= 0)
+		{
+			px = worldX[p];
+			py = worldY[p];
+			pz = worldZ[p];
+		}
+		worldX[i] = px + localX[i];
+		worldY[i] = py + localY[i];
+		worldZ[i] = pz + localZ[i];
+	}
+	for (int i = 0; i != n; ++i)
+		dirty[i] = false;
+	allDirty = false;
+	worldDirty = false;
+}
+
+void BodyStore::setWorld(const double *x, const double *y, const double *z, double scale)
+{
+	int n = size();
+	for (int i = 0; i < n; ++i)
+	{
+		worldX[i] = x[i] * scale;
+		worldY[i] = y[i] * scale;
+		worldZ[i] = z[i] * scale;
+		dirty[i] = false;
+	}
+	allDirty = false;
+	worldDirty = false;
+}
+
+void BodyStore::increaseRotation(int i)
+{
+	if (angleRotation[i] > 360.0)
+		angleRotation[i] -= 360.0;
+	angleRotation[i] += deltaRotation[i];
+}
+
+void BodyStore::increaseRevolution(int i)
+{
+	if (angleRevolution[i] > 360.0)
+		angleRevolution[i] -= 360.0;
+	setRevolution(i, angleRevolution[i] + deltaRevolution[i]);
+}
+
+void BodyStore::setRevolution(int i, double angle)
+{
+	angleRevolution[i] = angle;
+	updateOrbit(i);
+}
+
+void BodyStore::setRealDistanceMode(int i, bool realDistanceMode)
+{
+	this->realDistanceMode[i] = realDistanceMode;
+	updateDistance(i);
+}
+
+void BodyStore::setRealDistanceMode(bool realDistanceMode)
+{
+	for (int i = 0; i != size(); ++i)
+		setRealDistanceMode(i, realDistanceMode);
+}
+
+void BodyStore::updateDistance(int i)
+{
+	distance[i] = rescaleKm(realDistanceMode[i] ? distanceRevolution[i] : distanceRevolutionClose[i]);
+	orbitEccentricity[i] = realDistanceMode[i] ? eccentricity[i] : 0;
+	updateOrbit(i);
+}
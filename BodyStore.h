@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+
+// Struct-of-arrays storage for every body in the simulation.
+// Each property lives in its own contiguous array indexed by body id,
+// so a tick is a single pass over the arrays instead of a call per object.
+// A parent always has a smaller index than its children, so world positions
+// can be resolved in one forward pass.
+class BodyStore
+{
+public:
+	BodyStore(double timeScale = 100.0) : timeScale(timeScale) {}
+
+	// returns the index of the new body. parent is -1 for a root body.
+	int add(double radius, double distanceRevolution, double distanceRevolutionClose,
+		double hoursOfRotation, double hoursOfRevolution, double angleAxialTilt, int parent, double mass = 0);
+	int size() const { return (int)radius.size(); }
+	void reserve(int n);
+	// a store of only the given bodies and their parents, at epoch 0; selected
+	// receives the index of each of the bodies in it
+	static BodyStore subset(const BodyStore &source, const std::vector<int> &bodies, std::vector<int> &selected);
+
+	// advance every body by one tick
+	void advance();
+	// closed form: every angle computed directly from absolute time, O(n) regardless of t
+	void setEpoch(double hours);
+	double getEpoch() const { return epoch; }
+	void increaseRotation(int i);
+	void increaseRevolution(int i);
+
+	void setRotation(int i, double angle) { angleRotation[i] = angle; }
+	void setRevolution(int i, double angle);
+	void setRealDistanceMode(int i, bool realDistanceMode);
+	void setRealDistanceMode(bool realDistanceMode);
+	// Keplerian elements, angles in degree. The mean anomaly is the
+	// revolution angle plus meanAnomalyAtEpoch; distance is the semi-major axis.
+	void setOrbitElements(int i, double eccentricity, double inclination,
+		double longitudeOfNode, double argumentOfPeriapsis, double meanAnomalyAtEpoch);
+
+	double getTimeScale() const { return timeScale; }
+	double getHoursPerTick() const { return timeScale / 360.0; }
+
+	// world position, resolved at most once per change of the hierarchy
+	double getX(int i) { updateWorld(); return worldX[i]; }
+	double getY(int i) { updateWorld(); return worldY[i]; }
+	double getZ(int i) { updateWorld(); return worldZ[i]; }
+	void updateWorld();
+	// overrides the world positions, e.g. with a physics result, until the next change
+	void setWorld(const double *x, const double *y, const double *z, double scale);
+	void markDirty(int i) { dirty[i] = true; worldDirty = true; }
+	void markAllDirty() { allDirty = true; worldDirty = true; }
+
+	// properties, all indexed by body id
+	std::vector<double> radius; // km
+	std::vector<double> mass; // kg, 0 for a test particle
+	std::vector<double> distanceRevolution; // km
+	std::vector<double> distanceRevolutionClose; // km
+	std::vector<double> distance; // scene units, depends on realDistanceMode
+	std::vector<double> hoursOfRotation; // hours
+	std::vector<double> hoursOfRevolution; // hours
+	std::vector<double> angleAxialTilt; // degree
+	std::vector<double> angleRotation; // degree
+	std::vector<double> angleRevolution; // degree
+	std::vector<double> deltaRotation; // degree per tick
+	std::vector<double> deltaRevolution; // degree per tick
+	std::vector<double> rateRotation; // degree per hour
+	std::vector<double> rateRevolution; // degree per hour
+	std::vector<double> eccentricity;
+	std::vector<double> orbitEccentricity; // used for positions: 0 in close mode, where orbits stay circular
+	std::vector<double> inclination; // degree
+	std::vector<double> longitudeOfNode; // degree
+	std::vector<double> argumentOfPeriapsis; // degree
+	std::vector<double> meanAnomalyAtEpoch; // degree
+	std::vector<double> eccentricAnomaly; // radian
+	// orbit plane basis in scene axes: P towards periapsis, Q 90 degrees ahead
+	std::vector<double> orbitPX, orbitPY, orbitPZ;
+	std::vector<double> orbitQX, orbitQY, orbitQZ;
+	std::vector<double> localX; // position relative to the parent, scene units
+	std::vector<double> localY;
+	std::vector<double> localZ;
+	std::vector<int> parent;
+	std::vector<char> realDistanceMode;
+	std::vector<double> worldX;
+	std::vector<double> worldY;
+	std::vector<double> worldZ;
+
+	static double rescaleKm(double kilometer) { return kilometer / 6378; } // radius of the earth
+private:
+	double timeScale; // big: fast, small: slow.
+	double epoch = 0; // hours since all angles were zero
+	std::vector<char> dirty; // local position changed since the last updateWorld()
+	std::vector<double> scratch; // mean anomaly, then sin/cos of the eccentric anomaly
+	bool allDirty = false;
+	bool worldDirty = false;
+	void updateDistance(int i);
+	void updateOrbits();
+	void updateOrbit(int i);
+	static void wrapAdd(double *angle, const double *delta, int n);
+	static void phase(double *angle, const double *rate, double hours, int n);
+};
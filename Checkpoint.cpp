@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "Checkpoint.h"
+
+namespace
+{
+	const char MAGIC[4] = { 'S', 'C', 'H', 'K' };
+}
+
+void Checkpoint::begin(int bodies)
+{
+	data.clear();
+	position = 0;
+	failed = false;
+	error.clear();
+	data.insert(data.end(), MAGIC, MAGIC + 4);
+	write<uint32_t>(VERSION);
+	write<uint32_t>(bodies);
+}
+
+bool Checkpoint::beginRead(int bodies)
+{
+	position = 0;
+	failed = false;
+	error.clear();
+	uint32_t version = 0, count = 0;
+	if (data.size() < 4 || memcmp(&data[0], MAGIC, 4) != 0)
+	{
+		error = "not a checkpoint";
+		return false;
+	}
+	position = 4;
+	if (!read(version) || !read(count))
+	{
+		error = "truncated checkpoint";
+		return false;
+	}
+	if (version != VERSION)
+	{
+		error = "unsupported checkpoint version";
+		return false;
+	}
+	if ((int)count != bodies)
+	{
+		error = "checkpoint of another catalog";
+		return false;
+	}
+	return true;
+}
+
+bool Checkpoint::has(size_t bytes)
+{
+	if (failed || data.size() - position < bytes)
+	{
+		if (!failed)
+			error = "truncated checkpoint";
+		failed = true;
+		return false;
+	}
+	return true;
+}
+
+void Checkpoint::setData(const unsigned char *bytes, size_t size)
+{
+	data.assign(bytes, bytes + size);
+	position = 0;
+	failed = false;
+}
+
+bool Checkpoint::save(const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		error = std::string("cannot write ") + path;
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	if (fclose(file) != 0 || !ok)
+	{
+		error = std::string("cannot write ") + path;
+		return false;
+	}
+	return true;
+}
+
+bool Checkpoint::load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		error = std::string("cannot open ") + path;
+		return false;
+	}
+	data.clear();
+	unsigned char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		data.insert(data.end(), buffer, buffer + n);
+	bool ok = !ferror(file);
+	fclose(file);
+	position = 0;
+	failed = false;
+	if (!ok)
+		error = std::string("cannot read ") + path;
+	return ok;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <string.h>
+#include <string>
+#include <vector>
+
+// The whole state of a session in a compact binary buffer: written and
+// read back field by field, in the same order, by the classes that own the
+// state (Scene for the camera, Simulation for the bodies and the clock).
+// The version is bumped whenever that order changes.
+//
+// Layout (native little-endian):
+//   header      "SCHK", uint32 version, uint32 bodies
+//   camera      double theta, phi, distance, int32 view body, uint8 light 0, light 1
+//   simulation  int64 ticks, double start time, int64 clock ticks, double warp,
+//               uint8 paused, uint8 gravity, double epoch, uint8 real distance per body;
+//               in gravity mode double x, y, z, vx, vy, vz, ax, ay, az per body
+class Checkpoint
+{
+public:
+	static const unsigned VERSION = 1;
+
+	// starts a new checkpoint of that many bodies
+	void begin(int bodies);
+	// reads the header back; false if it is not a checkpoint of that many bodies
+	bool beginRead(int bodies);
+
+	template <typename T> void write(T value)
+	{
+		data.insert(data.end(), (const unsigned char *)&value, (const unsigned char *)&value + sizeof(value));
+	}
+	template <typename T> void writeArray(const std::vector<T> &values)
+	{
+		if (!values.empty())
+			data.insert(data.end(), (const unsigned char *)&values[0], (const unsigned char *)&values[0] + values.size() * sizeof(T));
+	}
+	// past the end a read fails, leaves the value alone, and so does every later one
+	template <typename T> bool read(T &value)
+	{
+		if (!has(sizeof(value)))
+			return false;
+		memcpy(&value, &data[position], sizeof(value));
+		position += sizeof(value);
+		return true;
+	}
+	template <typename T> bool readArray(std::vector<T> &values, size_t count)
+	{
+		if (!has(count * sizeof(T)))
+			return false;
+		values.resize(count);
+		if (count > 0)
+			memcpy(&values[0], &data[position], count * sizeof(T));
+		position += count * sizeof(T);
+		return true;
+	}
+	bool isFailed() const { return failed; }
+
+	bool save(const char *path);
+	bool load(const char *path);
+	const std::vector<unsigned char> &getData() const { return data; }
+	void setData(const unsigned char *bytes, size_t size);
+	const std::string &getError() const { return error; }
+private:
+	bool has(size_t bytes);
+
+	std::vector<unsigned char> data;
+	size_t position = 0; // of the next read
+	bool failed = false;
+	std::string error;
+};
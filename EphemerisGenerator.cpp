@@ -0,0 +1,132 @@
+#include <condition_variable>
+#include <mutex>
+#include "EphemerisGenerator.h"
+#include "EphemerisTable.h"
+
+EphemerisGenerator::EphemerisGenerator(const BodyStore &source, const std::vector<int> &bodies)
+	: store(BodyStore::subset(source, bodies, selected))
+{
+}
+
+void EphemerisGenerator::compute(Chunk &chunk, double start, double step, long long first, int count) const
+{
+	const double KM_PER_UNIT = 1.0 / BodyStore::rescaleKm(1.0);
+	size_t bodies = selected.size();
+	chunk.times.resize(count);
+	chunk.samples.resize(count * bodies);
+	for (int t = 0; t != count; ++t)
+	{
+		double hours = start + (first + t) * step; // no accumulated rounding
+		chunk.times[t] = hours;
+		chunk.store.setEpoch(hours);
+		chunk.store.updateWorld();
+		EphemerisSample *out = &chunk.samples[t * bodies];
+		for (size_t k = 0; k != bodies; ++k)
+		{
+			int i = selected[k];
+			out[k].x = chunk.store.worldX[i] * KM_PER_UNIT;
+			out[k].y = chunk.store.worldY[i] * KM_PER_UNIT;
+			out[k].z = chunk.store.worldZ[i] * KM_PER_UNIT;
+			out[k].rotation = (float)chunk.store.angleRotation[i];
+			out[k].revolution = (float)chunk.store.angleRevolution[i];
+		}
+	}
+}
+
+void EphemerisGenerator::computeSeries(Chunk &chunk, double start, double segment, long long first, int count, int degree) const
+{
+	const double KM_PER_UNIT = 1.0 / BodyStore::rescaleKm(1.0);
+	size_t bodies = selected.size();
+	int terms = degree + 1;
+	chunk.coefficients.resize((size_t)count * bodies * 3 * terms);
+	// by body, axis and node
+	chunk.values.resize(bodies * 3 * terms);
+	for (int s = 0; s != count; ++s)
+	{
+		double segmentStart = start + (first + s) * segment;
+		for (int k = 0; k != terms; ++k)
+		{
+			chunk.store.setEpoch(segmentStart + segment * 0.5 * (EphemerisTable::node(k, degree) + 1.0));
+			chunk.store.updateWorld();
+			for (size_t b = 0; b != bodies; ++b)
+			{
+				int i = selected[b];
+				double *values = &chunk.values[b * 3 * terms];
+				values[k] = chunk.store.worldX[i] * KM_PER_UNIT;
+				values[terms + k] = chunk.store.worldY[i] * KM_PER_UNIT;
+				values[2 * terms + k] = chunk.store.worldZ[i] * KM_PER_UNIT;
+			}
+		}
+		double *out = &chunk.coefficients[(size_t)s * bodies * 3 * terms];
+		for (size_t axis = 0; axis != bodies * 3; ++axis)
+			EphemerisTable::fit(&chunk.values[axis * terms], degree, out + axis * terms);
+	}
+}
+
+void EphemerisGenerator::run(double start, double step, long long count, ThreadPool &pool, EphemerisWriter &writer)
+{
+	long long chunks = (count + chunkSize - 1) / chunkSize;
+	pipeline(chunks, pool, [=](Chunk &chunk, long long index) {
+		long long first = index * chunkSize;
+		int n = (int)(count - first < chunkSize ? count - first : chunkSize);
+		compute(chunk, start, step, first, n);
+	}, [&writer](Chunk &chunk) {
+		writer.writeChunk(&chunk.times[0], (int)chunk.times.size(), chunk.samples.empty() ? NULL : &chunk.samples[0]);
+	});
+}
+
+bool EphemerisGenerator::fit(double start, double segment, long long segments, int degree, ThreadPool &pool, FILE *file)
+{
+	// as many positions per chunk as run() samples
+	int perChunk = chunkSize / (degree + 1) > 0 ? chunkSize / (degree + 1) : 1;
+	long long chunks = (segments + perChunk - 1) / perChunk;
+	bool ok = true;
+	pipeline(chunks, pool, [=](Chunk &chunk, long long index) {
+		long long first = index * perChunk;
+		int n = (int)(segments - first < perChunk ? segments - first : perChunk);
+		computeSeries(chunk, start, segment, first, n, degree);
+	}, [&ok, file](Chunk &chunk) {
+		size_t n = chunk.coefficients.size();
+		ok = ok && fwrite(&chunk.coefficients[0], sizeof(double), n, file) == n;
+	});
+	return ok;
+}
+
+void EphemerisGenerator::pipeline(long long chunks, ThreadPool &pool, const std::function<void(Chunk &, long long)> &compute,
+	const std::function<void(Chunk &)> &write)
+{
+	int window = 2 * pool.size() + 1;
+	std::vector<Chunk> slots(window);
+	for (int s = 0; s != window; ++s)
+	{
+		slots[s].store = store;
+		slots[s].done = false;
+	}
+
+	std::mutex mutex;
+	std::condition_variable finished;
+	long long submitted = 0;
+	for (long long written = 0; written != chunks; ++written)
+	{
+		// keep the window full, then write the oldest chunk when it is ready
+		for (; submitted != chunks && submitted - written < window; ++submitted)
+		{
+			Chunk *chunk = &slots[submitted % window];
+			long long index = submitted;
+			pool.submit([=, &compute, &mutex, &finished]() {
+				compute(*chunk, index);
+				std::lock_guard<std::mutex> lock(mutex);
+				chunk->done = true;
+				finished.notify_all();
+			});
+		}
+		Chunk &chunk = slots[written % window];
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&chunk]() { return chunk.done; });
+			chunk.done = false;
+		}
+		write(chunk);
+	}
+	pool.wait();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include <stdio.h>
+#include <vector>
+#include "BodyStore.h"
+#include "EphemerisWriter.h"
+#include "ThreadPool.h"
+
+// Samples body positions and angles over a time range without a display.
+// The range is cut into chunks of consecutive times that the pool computes
+// in parallel, each from the closed form (BodyStore::setEpoch), so chunks are
+// independent. Finished chunks go to the writer in time order; at most
+// two chunks per thread are in memory at once. fit() computes Chebyshev
+// series of the positions for an EphemerisTable the same way.
+class EphemerisGenerator
+{
+public:
+	// keeps a private copy of the requested bodies and their parents
+	EphemerisGenerator(const BodyStore &store, const std::vector<int> &bodies);
+
+	void setChunkSize(int samples) { chunkSize = samples > 0 ? samples : 1; }
+	// samples at start, start + step, ... for count times
+	void run(double start, double step, long long count, ThreadPool &pool, EphemerisWriter &writer);
+	// the coefficients of segments of that many hours, after EphemerisTable::writeHeader();
+	// false on a write error
+	bool fit(double start, double segment, long long segments, int degree, ThreadPool &pool, FILE *file);
+private:
+	std::vector<int> selected; // indices into store, filled before it
+	BodyStore store;
+	int chunkSize = 1024;
+
+	struct Chunk
+	{
+		BodyStore store; // every in-flight chunk needs its own angles
+		std::vector<double> times;
+		std::vector<EphemerisSample> samples;
+		std::vector<double> values; // fit(): positions at the nodes of one segment
+		std::vector<double> coefficients;
+		bool done;
+	};
+	void compute(Chunk &chunk, double start, double step, long long first, int count) const;
+	void computeSeries(Chunk &chunk, double start, double segment, long long first, int count, int degree) const;
+	// computes chunks 0 ... chunks - 1 on the pool and hands them to write in order
+	void pipeline(long long chunks, ThreadPool &pool, const std::function<void(Chunk &, long long)> &compute,
+		const std::function<void(Chunk &)> &write);
+};
@@ -0,0 +1,127 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "EphemerisTable.h"
+
+namespace
+{
+	const double PI = 3.14159265358979323846;
+	const size_t FIXED_HEADER = 4 + 3 * 4 + 8 + 2 * 8 + 8;
+
+	template <typename T> T get(const unsigned char *&p)
+	{
+		T value;
+		memcpy(&value, p, sizeof(value));
+		p += sizeof(value);
+		return value;
+	}
+
+	template <typename T> void put(std::vector<unsigned char> &out, T value)
+	{
+		out.insert(out.end(), (const unsigned char *)&value, (const unsigned char *)&value + sizeof(value));
+	}
+}
+
+bool EphemerisTable::open(const char *path)
+{
+	names.clear();
+	coefficients = NULL;
+	if (!file.open(path))
+	{
+		error = std::string(path) + ": cannot open";
+		return false;
+	}
+	const unsigned char *begin = file.getData(), *end = begin + file.getSize();
+	const unsigned char *p = begin;
+	bool ok = file.getSize() >= FIXED_HEADER && memcmp(p, "EPHC", 4) == 0;
+	uint32_t bodies = 0, degree = 0;
+	uint64_t dataOffset = 0;
+	if (ok)
+	{
+		p += 4;
+		ok = get<uint32_t>(p) == VERSION;
+		bodies = get<uint32_t>(p);
+		degree = get<uint32_t>(p);
+		segments = (long long)get<uint64_t>(p);
+		start = get<double>(p);
+		segment = get<double>(p);
+		dataOffset = get<uint64_t>(p);
+		// unsigned, so a huge degree cannot wrap to a small term count
+		ok = ok && bodies > 0 && degree >= 1 && degree <= (uint32_t)MAX_TERMS - 2 && segments > 0 && segment > 0 && dataOffset % 8 == 0;
+	}
+	for (uint32_t i = 0; ok && i != bodies; ++i)
+	{
+		ok = end - p >= 2;
+		uint16_t length = ok ? get<uint16_t>(p) : 0;
+		ok = ok && end - p >= length;
+		if (ok)
+		{
+			names.push_back(std::string((const char *)p, length));
+			p += length;
+		}
+	}
+	// the coefficients must be all there, after the names
+	terms = ok ? (int)degree + 1 : 0;
+	ok = ok && dataOffset >= (uint64_t)(p - begin) && dataOffset <= file.getSize()
+		&& (file.getSize() - dataOffset) / (3 * terms * sizeof(double)) / bodies >= (uint64_t)segments;
+	if (!ok)
+	{
+		file.close();
+		names.clear();
+		error = std::string(path) + ": not an ephemeris table";
+		return false;
+	}
+	coefficients = (const double *)(begin + dataOffset);
+	return true;
+}
+
+int EphemerisTable::find(const char *name) const
+{
+	for (size_t i = 0; i != names.size(); ++i)
+		if (names[i] == name)
+			return (int)i;
+	return -1;
+}
+
+bool EphemerisTable::writeHeader(FILE *file, const std::vector<const char *> &names, double start, double segment,
+	unsigned long long segments, int degree)
+{
+	std::vector<unsigned char> header;
+	header.insert(header.end(), "EPHC", "EPHC" + 4);
+	put<uint32_t>(header, VERSION);
+	put<uint32_t>(header, (uint32_t)names.size());
+	put<uint32_t>(header, (uint32_t)degree);
+	put<uint64_t>(header, segments);
+	put<double>(header, start);
+	put<double>(header, segment);
+	size_t offsetAt = header.size();
+	put<uint64_t>(header, 0);
+	for (size_t i = 0; i != names.size(); ++i)
+	{
+		uint16_t length = (uint16_t)strlen(names[i]);
+		put<uint16_t>(header, length);
+		header.insert(header.end(), names[i], names[i] + length);
+	}
+	// coefficients aligned in the mapping
+	header.resize((header.size() + 63) / 64 * 64, 0);
+	uint64_t dataOffset = header.size();
+	memcpy(&header[offsetAt], &dataOffset, sizeof(dataOffset));
+	return fwrite(&header[0], 1, header.size(), file) == header.size();
+}
+
+double EphemerisTable::node(int k, int degree)
+{
+	return cos(PI * (k + 0.5) / (degree + 1));
+}
+
+void EphemerisTable::fit(const double *values, int degree, double *coefficients)
+{
+	int n = degree + 1;
+	for (int j = 0; j != n; ++j)
+	{
+		double sum = 0;
+		for (int k = 0; k != n; ++k)
+			sum += values[k] * cos(PI * j * (k + 0.5) / n);
+		coefficients[j] = (j == 0 ? 1.0 : 2.0) * sum / n;
+	}
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Precomputed body positions: the time range is cut into segments of equal
+// length, and in every segment each coordinate of each body is a Chebyshev
+// series. A lookup finds its segment by division, evaluates the Chebyshev
+// polynomials at the time once and takes one dot product per coordinate, a
+// multiply-add per coefficient, so it costs the same anywhere in the range.
+// Looking up every body at one time shares the polynomials and the segment,
+// and the dot products of different bodies run in parallel. The file is
+// memory mapped: it opens without reading, and processes using the same
+// table share its pages.
+//
+// Layout (native little-endian):
+//   header  "EPHC", uint32 version, uint32 bodies, uint32 degree, uint64 segments,
+//           double start, double segment, uint64 dataOffset
+//   names   per body: uint16 length, characters
+//   data    at dataOffset (a multiple of 64), per segment, per body:
+//           x, y, z coefficients, degree + 1 doubles each, km
+class EphemerisTable
+{
+public:
+	static const unsigned VERSION = 1;
+
+	bool open(const char *path);
+	void close() { file.close(); }
+	bool isOpen() const { return file.isOpen(); }
+	const std::string &getError() const { return error; }
+
+	int size() const { return (int)names.size(); }
+	const char *getName(int body) const { return names[body].c_str(); }
+	// -1 if no body has that name
+	int find(const char *name) const;
+	double getStart() const { return start; }
+	double getEnd() const { return start + segments * segment; }
+
+	// km at simulated hours; false outside the table
+	bool position(int body, double hours, double &x, double &y, double &z) const
+	{
+		double t[MAX_TERMS];
+		const double *c = basis(hours, t);
+		if (c == NULL)
+			return false;
+		evaluate(c + (size_t)body * 3 * terms, t, x, y, z);
+		return true;
+	}
+	// every body, x[size()], ...; the same values as position()
+	bool positions(double hours, double *x, double *y, double *z) const
+	{
+		double t[MAX_TERMS];
+		const double *c = basis(hours, t);
+		if (c == NULL)
+			return false;
+		for (size_t body = 0; body != names.size(); ++body, c += 3 * terms)
+			evaluate(c, t, x[body], y[body], z[body]);
+		return true;
+	}
+
+	// writing, for EphemerisGenerator::fit(); returns false on a write error
+	static bool writeHeader(FILE *file, const std::vector<const char *> &names, double start, double segment,
+		unsigned long long segments, int degree);
+	// the degree + 1 coefficients of a series from its values at the Chebyshev
+	// nodes cos(pi (k + 1/2) / (degree + 1)), k = 0 ... degree
+	static void fit(const double *values, int degree, double *coefficients);
+	static double node(int k, int degree);
+private:
+	static const int MAX_TERMS = 64;
+
+	// the Chebyshev polynomials at the time in t[terms] and the coefficients of its segment
+	const double *basis(double hours, double *t) const
+	{
+		double position = (hours - start) / segment;
+		if (!(position >= 0 && position <= (double)segments))
+			return NULL;
+		long long s = (long long)position;
+		if (s == segments)
+			--s; // the end belongs to the last segment
+		double u = 2.0 * (position - s) - 1.0;
+		t[0] = 1;
+		t[1] = u;
+		for (int j = 2; j < terms; ++j)
+			t[j] = 2.0 * u * t[j - 1] - t[j - 2];
+		return coefficients + (size_t)s * names.size() * 3 * terms;
+	}
+	void evaluate(const double *c, const double *t, double &x, double &y, double &z) const
+	{
+		const double *cy = c + terms, *cz = cy + terms;
+		double sx = 0, sy = 0, sz = 0;
+		for (int j = 0; j < terms; ++j)
+		{
+			sx += c[j] * t[j];
+			sy += cy[j] * t[j];
+			sz += cz[j] * t[j];
+		}
+		x = sx;
+		y = sy;
+		z = sz;
+	}
+
+	MappedFile file;
+	std::vector<std::string> names;
+	int terms = 0; // degree + 1
+	long long segments = 0;
+	double start = 0;
+	double segment = 1; // hours
+	const double *coefficients = NULL;
+	std::string error;
+};
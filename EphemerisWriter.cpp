@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <string.h>
+#include "EphemerisWriter.h"
+
+void EphemerisWriter::writeHeader(const std::vector<const char *> &names, double start, double step, unsigned long long samples)
+{
+	this->names = names;
+	if (format == CSV)
+	{
+		fputs("hours,body,x_km,y_km,z_km,rotation_deg,revolution_deg\n", file);
+		return;
+	}
+	uint32_t version = VERSION;
+	uint32_t bodies = (uint32_t)names.size();
+	uint64_t count = samples;
+	fwrite("EPHM", 1, 4, file);
+	fwrite(&version, sizeof(version), 1, file);
+	fwrite(&bodies, sizeof(bodies), 1, file);
+	fwrite(&count, sizeof(count), 1, file);
+	fwrite(&start, sizeof(start), 1, file);
+	fwrite(&step, sizeof(step), 1, file);
+	for (size_t i = 0; i != names.size(); ++i)
+	{
+		uint16_t length = (uint16_t)strlen(names[i]);
+		fwrite(&length, sizeof(length), 1, file);
+		fwrite(names[i], 1, length, file);
+	}
+}
+
+void EphemerisWriter::writeChunk(const double *times, int count, const EphemerisSample *samples)
+{
+	size_t bodies = names.size();
+	if (format == BINARY)
+	{
+		size_t record = sizeof(double) + bodies * sizeof(EphemerisSample);
+		buffer.resize(record * count);
+		if (buffer.empty())
+			return;
+		char *p = &buffer[0];
+		for (int t = 0; t != count; ++t)
+		{
+			memcpy(p, &times[t], sizeof(double));
+			memcpy(p + sizeof(double), samples + t * bodies, bodies * sizeof(EphemerisSample));
+			p += record;
+		}
+		fwrite(&buffer[0], 1, buffer.size(), file);
+		return;
+	}
+	for (int t = 0; t != count; ++t)
+	{
+		for (size_t b = 0; b != bodies; ++b)
+		{
+			const EphemerisSample &s = samples[t * bodies + b];
+			fprintf(file, "%.10g,%s,%.10g,%.10g,%.10g,%.7g,%.7g\n",
+				times[t], names[b], s.x, s.y, s.z, s.rotation, s.revolution);
+		}
+	}
+}
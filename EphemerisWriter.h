@@ -0,0 +1,37 @@
+#pragma once
+#include <stdio.h>
+#include <vector>
+
+// One body at one time.
+struct EphemerisSample
+{
+	double x, y, z; // km
+	float rotation; // degree
+	float revolution; // degree
+};
+
+// Streams ephemeris samples to a file as they are produced.
+//
+// Binary layout (native little-endian):
+//   header  "EPHM", uint32 version, uint32 bodies, uint64 samples, double start, double step
+//   names   per body: uint16 length, characters
+//   records per time: double hours, then one EphemerisSample (32 bytes) per body
+// CSV has one line per body and time: hours,body,x,y,z,rotation,revolution
+class EphemerisWriter
+{
+public:
+	enum Format { BINARY, CSV };
+	static const unsigned VERSION = 1;
+
+	EphemerisWriter(FILE *file, Format format) : file(file), format(format) {}
+
+	void writeHeader(const std::vector<const char *> &names, double start, double step, unsigned long long samples);
+	// times[count], samples[count * bodies] ordered by time, then body
+	void writeChunk(const double *times, int count, const EphemerisSample *samples);
+	bool failed() const { return ferror(file) != 0; }
+private:
+	FILE *file;
+	Format format;
+	std::vector<const char *> names;
+	std::vector<char> buffer;
+};
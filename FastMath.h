@@ -0,0 +1,106 @@
+#pragma once
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FASTMATH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Batched sine/cosine of angles given in degrees.
+// The angle is reduced to a quadrant in degrees (exact), then evaluated with
+// the cephes minimax polynomials on [-45, 45] degrees. Error is below 1e-15.
+namespace FastMath
+{
+	const double PI = 3.14159265358979323846;
+	const double RADIAN_PER_DEGREE = PI / 180.0;
+
+	// polynomial coefficients for |x| <= pi/4
+	const double SIN_C0 = 1.58962301576546568060E-10;
+	const double SIN_C1 = -2.50507477628578072866E-8;
+	const double SIN_C2 = 2.75573136213857245213E-6;
+	const double SIN_C3 = -1.98412698295895385996E-4;
+	const double SIN_C4 = 8.33333333332211858878E-3;
+	const double SIN_C5 = -1.66666666666666307295E-1;
+	const double COS_C0 = -1.13585365213876817300E-11;
+	const double COS_C1 = 2.08757008419747316778E-9;
+	const double COS_C2 = -2.75573141792967388112E-7;
+	const double COS_C3 = 2.48015872888517045348E-5;
+	const double COS_C4 = -1.38888888888730564116E-3;
+	const double COS_C5 = 4.16666666666665929218E-2;
+
+	inline void sinCosDegree(double degree, double &s, double &c)
+	{
+		double q = degree / 90.0;
+		q = (q >= 0) ? (double)(long long)(q + 0.5) : -(double)(long long)(-q + 0.5);
+		double x = (degree - 90.0 * q) * RADIAN_PER_DEGREE;
+		double z = x * x;
+		double ps = x + x * z * (((((SIN_C0 * z + SIN_C1) * z + SIN_C2) * z + SIN_C3) * z + SIN_C4) * z + SIN_C5);
+		double pc = 1.0 - 0.5 * z + z * z * (((((COS_C0 * z + COS_C1) * z + COS_C2) * z + COS_C3) * z + COS_C4) * z + COS_C5);
+		int quadrant = (int)((long long)q & 3);
+		switch (quadrant)
+		{
+		case 0: s = ps; c = pc; break;
+		case 1: s = pc; c = -ps; break;
+		case 2: s = -ps; c = -pc; break;
+		default: s = -pc; c = ps; break;
+		}
+	}
+
+	// s[i] = sin(degree[i]), c[i] = cos(degree[i]) for i in [0, n)
+	// |degree| must stay below 2^31 * 90.
+	inline void sinCosDegree(const double *degree, double *s, double *c, size_t n)
+	{
+		size_t i = 0;
+#ifdef FASTMATH_SSE2
+		const __m128d inv90 = _mm_set1_pd(1.0 / 90.0);
+		const __m128d ninety = _mm_set1_pd(90.0);
+		const __m128d toRadian = _mm_set1_pd(RADIAN_PER_DEGREE);
+		const __m128d half = _mm_set1_pd(0.5);
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d signBit = _mm_set1_pd(-0.0);
+		const __m128i one32 = _mm_set1_epi32(1);
+		const __m128i two32 = _mm_set1_epi32(2);
+		for (; i + 2 <= n; i += 2)
+		{
+			__m128d d = _mm_loadu_pd(degree + i);
+			__m128i qi = _mm_cvtpd_epi32(_mm_mul_pd(d, inv90)); // round to nearest
+			__m128d q = _mm_cvtepi32_pd(qi);
+			__m128d x = _mm_mul_pd(_mm_sub_pd(d, _mm_mul_pd(ninety, q)), toRadian);
+			__m128d z = _mm_mul_pd(x, x);
+
+			__m128d ps = _mm_set1_pd(SIN_C0);
+			ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(SIN_C1));
+			ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(SIN_C2));
+			ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(SIN_C3));
+			ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(SIN_C4));
+			ps = _mm_add_pd(_mm_mul_pd(ps, z), _mm_set1_pd(SIN_C5));
+			ps = _mm_add_pd(x, _mm_mul_pd(_mm_mul_pd(x, z), ps));
+
+			__m128d pc = _mm_set1_pd(COS_C0);
+			pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(COS_C1));
+			pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(COS_C2));
+			pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(COS_C3));
+			pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(COS_C4));
+			pc = _mm_add_pd(_mm_mul_pd(pc, z), _mm_set1_pd(COS_C5));
+			pc = _mm_add_pd(_mm_sub_pd(one, _mm_mul_pd(half, z)), _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+			// widen the two 32-bit quadrant flags to 64-bit lane masks
+			__m128i swap32 = _mm_cmpeq_epi32(_mm_and_si128(qi, one32), one32);
+			__m128i sinNeg32 = _mm_cmpeq_epi32(_mm_and_si128(qi, two32), two32);
+			__m128i cosNeg32 = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(qi, one32), two32), two32);
+			__m128d swap = _mm_castsi128_pd(_mm_shuffle_epi32(swap32, _MM_SHUFFLE(1, 1, 0, 0)));
+			__m128d sinNeg = _mm_castsi128_pd(_mm_shuffle_epi32(sinNeg32, _MM_SHUFFLE(1, 1, 0, 0)));
+			__m128d cosNeg = _mm_castsi128_pd(_mm_shuffle_epi32(cosNeg32, _MM_SHUFFLE(1, 1, 0, 0)));
+
+			__m128d rs = _mm_or_pd(_mm_and_pd(swap, pc), _mm_andnot_pd(swap, ps));
+			__m128d rc = _mm_or_pd(_mm_and_pd(swap, ps), _mm_andnot_pd(swap, pc));
+			rs = _mm_xor_pd(rs, _mm_and_pd(sinNeg, signBit));
+			rc = _mm_xor_pd(rc, _mm_and_pd(cosNeg, signBit));
+			_mm_storeu_pd(s + i, rs);
+			_mm_storeu_pd(c + i, rc);
+		}
+#endif
+		for (; i < n; ++i)
+			sinCosDegree(degree[i], s[i], c[i]);
+	}
+}
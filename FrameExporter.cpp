@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+#include "FrameExporter.h"
+#include "GLExtensions.h"
+
+namespace
+{
+	// the pattern goes to snprintf, so it may hold %% and exactly one %d, with a width
+	bool isFramePattern(const char *pattern)
+	{
+		int conversions = 0;
+		for (const char *p = pattern; *p != 0; ++p)
+		{
+			if (*p != '%')
+				continue;
+			if (*++p == '%')
+				continue;
+			while (*p >= '0' && *p <= '9')
+				++p;
+			if (*p != 'd')
+				return false;
+			++conversions;
+		}
+		return conversions == 1;
+	}
+}
+
+bool FrameExporter::start(const char *outputPattern, int frameWidth, int frameHeight)
+{
+	finish();
+	error.clear();
+	if (strcmp(outputPattern, "-") != 0 && !isFramePattern(outputPattern))
+	{
+		error = "the output pattern needs exactly one %d for the frame number";
+		return false;
+	}
+	pattern = outputPattern;
+	width = frameWidth;
+	height = frameHeight;
+	stream = NULL;
+	if (pattern == "-")
+	{
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		stream = stdout;
+	}
+
+	size_t bytes = (size_t)width * height * 3;
+	frames.assign(queueLength + 1, Frame());
+	freeFrames.clear();
+	for (int f = 0; f != (int)frames.size(); ++f)
+	{
+		frames[f].pixels.resize(bytes);
+		freeFrames.push_back(f);
+	}
+	queue.clear();
+	if (GLExt::isLoaded())
+	{
+		GLExt::GenBuffers(RING, buffers);
+		for (int b = 0; b != RING; ++b)
+		{
+			GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[b]);
+			GLExt::BufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+		}
+		GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+	head = inFlight = 0;
+	nextNumber = 0;
+	stopping = writeFailed = false;
+	Stats empty = {};
+	stats = empty;
+	startTime = std::chrono::steady_clock::now();
+	writer = std::thread(&FrameExporter::writerLoop, this);
+	running = true;
+	return true;
+}
+
+void FrameExporter::capture()
+{
+	if (!running)
+		return;
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	if (buffers[0] == 0)
+	{
+		int f = acquire();
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &frames[f].pixels[0]);
+		submit(f);
+		return;
+	}
+	// returns at once; the copy lands in the buffer when the frame is done
+	GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[head]);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	head = (head + 1) % RING;
+	if (++inFlight == RING)
+	{
+		collect(head); // the oldest
+		--inFlight;
+	}
+}
+
+void FrameExporter::collect(int buffer)
+{
+	int f = acquire();
+	GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[buffer]);
+	const void *pixels = GLExt::MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (pixels != NULL)
+	{
+		memcpy(&frames[f].pixels[0], pixels, frames[f].pixels.size());
+		GLExt::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	GLExt::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	submit(f);
+}
+
+int FrameExporter::acquire()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (freeFrames.empty())
+	{
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+		released.wait(lock, [this]() { return !freeFrames.empty(); });
+		++stats.stalls;
+		stats.stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+	int f = freeFrames.back();
+	freeFrames.pop_back();
+	return f;
+}
+
+void FrameExporter::submit(int frame)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	frames[frame].number = nextNumber++;
+	++stats.captured;
+	queue.push_back(frame);
+	queued.notify_one();
+}
+
+void FrameExporter::finish()
+{
+	if (!running)
+		return;
+	for (; inFlight > 0; --inFlight)
+		collect((head - inFlight + RING) % RING);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+		queued.notify_one();
+	}
+	writer.join();
+	if (buffers[0] != 0)
+		GLExt::DeleteBuffers(RING, buffers);
+	memset(buffers, 0, sizeof(buffers));
+	if (stream != NULL)
+		fflush(stream);
+	stream = NULL;
+	frames.clear();
+	running = false;
+	std::lock_guard<std::mutex> lock(mutex);
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	if (writeFailed && error.empty())
+		error = "cannot write the frames";
+}
+
+FrameExporter::Stats FrameExporter::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Stats current = stats;
+	if (running)
+		current.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return current;
+}
+
+void FrameExporter::writerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		queued.wait(lock, [this]() { return stopping || !queue.empty(); });
+		if (queue.empty())
+			return; // stopping, everything written
+		int f = queue.front();
+		queue.pop_front();
+		lock.unlock();
+		bool ok = !writeFailed && write(frames[f]);
+		lock.lock();
+		if (ok)
+			++stats.written;
+		else
+			writeFailed = true;
+		freeFrames.push_back(f);
+		released.notify_one();
+	}
+}
+
+bool FrameExporter::write(const Frame &frame)
+{
+	FILE *file = stream;
+	if (file == NULL)
+	{
+		char path[1024];
+		snprintf(path, sizeof(path), pattern.c_str(), (int)frame.number);
+		file = fopen(path, "wb");
+		if (file == NULL)
+			return false;
+	}
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	size_t row = (size_t)width * 3;
+	bool ok = true;
+	for (int y = height - 1; y >= 0 && ok; --y) // bottom-up in OpenGL
+		ok = fwrite(&frame.pixels[y * row], 1, row, file) == row;
+	if (file != stream)
+		ok = fclose(file) == 0 && ok;
+	return ok;
+}
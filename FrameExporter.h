@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLHeaders.h"
+
+// Writes rendered frames to image files without stalling the renderer.
+// capture() starts an asynchronous glReadPixels into one of a ring of pixel
+// buffer objects and maps the oldest one, which the GPU finished RING - 1
+// frames earlier. Its pixels are copied into a frame that goes through a
+// bounded queue to a writer thread, which writes it as a binary PPM. When
+// the writer falls behind, capture() waits for a free frame; those waits
+// are the stalls in the stats. Without buffer objects (OpenGL 3.3 not
+// loaded) the read is synchronous but the writing still overlaps.
+class FrameExporter
+{
+public:
+	static const int RING = 3;
+
+	struct Stats
+	{
+		long long captured;
+		long long written;
+		long long stalls; // captures that waited for the writer
+		double stallSeconds;
+		double seconds; // since start(), up to finish()
+	};
+
+	explicit FrameExporter(int queueLength = 8) : queueLength(queueLength) {}
+	~FrameExporter() { finish(); }
+
+	// pattern holds one %d for the frame number, optionally with a width, e.g.
+	// frame_%05d.ppm, and no other conversion but %%; "-" streams every frame to standard output (for
+	// ffmpeg -f image2pipe). Needs a current context.
+	bool start(const char *pattern, int width, int height);
+	bool isRunning() const { return running; }
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+	const std::string &getError() const { return error; }
+	// after the frame is drawn, before it is swapped
+	void capture();
+	// reads the frames still in flight, waits for the writer and closes the output
+	void finish();
+	Stats getStats() const;
+private:
+	FrameExporter(const FrameExporter &);
+	FrameExporter &operator=(const FrameExporter &);
+
+	struct Frame
+	{
+		std::vector<unsigned char> pixels; // RGB, bottom-up
+		long long number;
+	};
+
+	int acquire(); // a free frame, waiting for the writer if there is none
+	void submit(int frame);
+	void collect(int buffer); // maps a ring buffer into a frame
+	void writerLoop();
+	bool write(const Frame &frame);
+
+	int queueLength;
+	bool running = false;
+	int width = 0;
+	int height = 0;
+	std::string pattern;
+	FILE *stream = NULL; // for "-"
+	std::string error;
+
+	GLuint buffers[RING] = {};
+	int head = 0; // next ring buffer to read into
+	int inFlight = 0;
+	long long nextNumber = 0;
+
+	std::vector<Frame> frames;
+	std::vector<int> freeFrames;
+	std::deque<int> queue;
+	bool stopping = false;
+	bool writeFailed = false;
+	mutable std::mutex mutex;
+	std::condition_variable queued;
+	std::condition_variable released;
+	std::thread writer;
+	Stats stats = {};
+	std::chrono::steady_clock::time_point startTime;
+};
@@ -0,0 +1,64 @@
+#include <math.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+#include "FrameScheduler.h"
+
+namespace
+{
+	const double WINDOW_SECONDS = 1.0;
+}
+
+FrameScheduler::FrameScheduler(double targetFps)
+	: targetFps(targetFps), lastFrame(Clock::now()), windowStart(lastFrame), windowCpu(processCpuSeconds())
+{
+}
+
+int FrameScheduler::getDelayMs() const
+{
+	if (!animating && !requested)
+		return -1;
+	if (targetFps <= 0)
+		return 0;
+	double due = 1.0 / targetFps - std::chrono::duration<double>(Clock::now() - lastFrame).count();
+	return due > 0 ? (int)ceil(due * 1000.0) : 0;
+}
+
+void FrameScheduler::frameStarted()
+{
+	requested = false;
+	lastFrame = Clock::now();
+	++windowFrames;
+	double seconds = std::chrono::duration<double>(lastFrame - windowStart).count();
+	if (seconds < WINDOW_SECONDS)
+		return;
+	double cpu = processCpuSeconds();
+	stats.fps = windowFrames / seconds;
+	stats.cpu = (cpu - windowCpu) / seconds;
+	++stats.windows;
+	windowStart = lastFrame;
+	windowCpu = cpu;
+	windowFrames = 0;
+}
+
+double FrameScheduler::processCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) * 1e-7; // 100 ns units
+#else
+	timespec t;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0)
+		return 0;
+	return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+
+// Decides when the next frame is drawn. While the scene animates a frame
+// is due every 1 / target seconds; otherwise only when something asked for
+// one, and requests that arrive before the frame is due are drawn together.
+// When neither holds there is nothing to draw and the caller can sleep
+// until the next request. Measures the frame rate and the CPU time of the
+// process (all threads) over windows of about a second.
+class FrameScheduler
+{
+public:
+	struct Stats
+	{
+		double fps;
+		double cpu; // CPU seconds per second, 1 is one busy core
+		long long windows; // measured so far; changes when the numbers do
+	};
+
+	// 0: no limit, the swap paces to the display refresh if the driver syncs
+	explicit FrameScheduler(double targetFps = 60);
+
+	void setTargetFps(double fps) { targetFps = fps; }
+	double getTargetFps() const { return targetFps; }
+	void setAnimating(bool on) { animating = on; }
+	void requestFrame() { requested = true; }
+
+	// ms until the next frame is due, 0 for now, -1 when nothing is to be drawn
+	int getDelayMs() const;
+	// when the frame is drawn; the requests so far are part of it
+	void frameStarted();
+	const Stats &getStats() const { return stats; }
+
+	// CPU time the process used so far, every thread
+	static double processCpuSeconds();
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double targetFps;
+	bool animating = false;
+	bool requested = true; // the first frame
+	Clock::time_point lastFrame;
+
+	Clock::time_point windowStart;
+	double windowCpu;
+	int windowFrames = 0;
+	Stats stats = {};
+};
@@ -0,0 +1,79 @@
+#include <math.h>
+#include "FrustumCuller.h"
+
+void FrustumCuller::setView(const double *projection, const double *modelView,
+	double cameraX, double cameraY, double cameraZ)
+{
+	// clip = projection * modelView; the planes are sums and differences of its rows
+	double m[16];
+	for (int column = 0; column != 4; ++column)
+		for (int row = 0; row != 4; ++row)
+		{
+			double sum = 0;
+			for (int k = 0; k != 4; ++k)
+				sum += projection[k * 4 + row] * modelView[column * 4 + k];
+			m[column * 4 + row] = sum;
+		}
+	for (int p = 0; p != 6; ++p)
+	{
+		int row = p / 2;
+		double sign = (p % 2) ? -1.0 : 1.0;
+		double length = 0;
+		for (int c = 0; c != 4; ++c)
+		{
+			planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+			if (c < 3)
+				length += planes[p][c] * planes[p][c];
+		}
+		length = sqrt(length);
+		for (int c = 0; c != 4 && length > 0; ++c)
+			planes[p][c] /= length;
+	}
+	camera[0] = cameraX;
+	camera[1] = cameraY;
+	camera[2] = cameraZ;
+}
+
+bool FrustumCuller::intersects(double x, double y, double z, double radius) const
+{
+	for (int p = 0; p != 6; ++p)
+		if (planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3] < -radius)
+			return false;
+	return true;
+}
+
+bool FrustumCuller::isBehindParent(BodyStore &store, int i) const
+{
+	int p = store.parent[i];
+	if (p < 0)
+		return false;
+	double bx = store.getX(i) - camera[0], by = store.getY(i) - camera[1], bz = store.getZ(i) - camera[2];
+	double px = store.getX(p) - camera[0], py = store.getY(p) - camera[1], pz = store.getZ(p) - camera[2];
+	double bodyDistance = sqrt(bx * bx + by * by + bz * bz);
+	double parentDistance = sqrt(px * px + py * py + pz * pz);
+	double bodyRadius = boundingRadius(store, i), parentRadius = boundingRadius(store, p);
+	// wholly farther than the parent's center, and its disc inside the parent's disc
+	if (parentDistance <= parentRadius || bodyDistance - bodyRadius <= parentDistance)
+		return false;
+	double cosine = (bx * px + by * py + bz * pz) / (bodyDistance * parentDistance);
+	double separation = acos(cosine > 1.0 ? 1.0 : (cosine < -1.0 ? -1.0 : cosine));
+	return separation + asin(bodyRadius / bodyDistance) < asin(parentRadius / parentDistance);
+}
+
+void FrustumCuller::cull(BodyStore &store, std::vector<int> &visible)
+{
+	visible.clear();
+	stats.tested = store.size();
+	stats.outside = stats.occluded = 0;
+	store.updateWorld();
+	for (int i = 0; i != store.size(); ++i)
+	{
+		if (!intersects(store.worldX[i], store.worldY[i], store.worldZ[i], boundingRadius(store, i)))
+			++stats.outside;
+		else if (isBehindParent(store, i))
+			++stats.occluded;
+		else
+			visible.push_back(i);
+	}
+	stats.drawn = (int)visible.size();
+}
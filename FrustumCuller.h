@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include "BodyStore.h"
+
+// Decides which bodies can be on screen before anything is drawn.
+// Every body is bounded by its sphere. A body is culled when the sphere is
+// outside one of the six frustum planes, or when it is completely hidden
+// behind its parent as seen from the camera (moons behind their planet,
+// planets behind the Sun), which is tested analytically.
+class FrustumCuller
+{
+public:
+	struct Stats
+	{
+		int tested;
+		int outside; // outside the frustum
+		int occluded; // behind the parent
+		int drawn;
+	};
+
+	// column-major matrices as returned by glGetDoublev; the camera is in world coordinates
+	void setView(const double *projection, const double *modelView, double cameraX, double cameraY, double cameraZ);
+	bool intersects(double x, double y, double z, double radius) const;
+	bool isBehindParent(BodyStore &store, int i) const;
+
+	// indices of the bodies that may be visible, in store order
+	void cull(BodyStore &store, std::vector<int> &visible);
+	const Stats &getStats() const { return stats; }
+
+	// bounding sphere in scene units
+	static double boundingRadius(const BodyStore &store, int i) { return BodyStore::rescaleKm(store.radius[i]); }
+private:
+	double planes[6][4]; // a x + b y + c z + d >= 0 inside, normalized
+	double camera[3];
+	Stats stats = { 0, 0, 0, 0 };
+};
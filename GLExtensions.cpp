@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include "GLExtensions.h"
+#if defined(GLEXT_EGL)
+#include <EGL/egl.h>
+#elif !defined(_WIN32)
+#include <GL/glx.h>
+#endif
+
+namespace GLExt
+{
+#define GLEXT_DEFINE(result, name, parameters) name##Proc name = NULL;
+	GLEXT_FUNCTIONS(GLEXT_DEFINE)
+#undef GLEXT_DEFINE
+
+	namespace
+	{
+		bool loaded = false;
+	}
+
+	void *getProcAddress(const char *name)
+	{
+#ifdef _WIN32
+		void *p = (void *)wglGetProcAddress(name);
+		// some drivers return small integers instead of NULL
+		if (p == (void *)1 || p == (void *)2 || p == (void *)3 || p == (void *)-1)
+			return NULL;
+		return p;
+#elif defined(GLEXT_EGL)
+		return (void *)eglGetProcAddress(name);
+#else
+		return (void *)glXGetProcAddressARB((const GLubyte *)name);
+#endif
+	}
+
+	bool load()
+	{
+		const char *version = (const char *)glGetString(GL_VERSION);
+		int major = 0, minor = 0;
+		if (version == NULL || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33)
+			return loaded = false;
+
+		bool complete = true;
+#define GLEXT_LOAD(result, name, parameters) \
+		name = (name##Proc)getProcAddress("gl" #name); \
+		complete = complete && name != NULL;
+		GLEXT_FUNCTIONS(GLEXT_LOAD)
+#undef GLEXT_LOAD
+		return loaded = complete;
+	}
+
+	bool isLoaded()
+	{
+		return loaded;
+	}
+}
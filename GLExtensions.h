@@ -0,0 +1,64 @@
+#pragma once
+#include "GLHeaders.h"
+
+// Entry points beyond OpenGL 1.1, loaded at run time once a context exists.
+// Call them as GLExt::GenBuffers(...). load() fails unless the context is
+// OpenGL 3.3 or newer and every entry point was found; callers then keep to
+// the fixed-function path.
+#define GLEXT_FUNCTIONS(F) \
+	F(void, ActiveTexture, (GLenum texture)) \
+	F(void, GenBuffers, (GLsizei n, GLuint *buffers)) \
+	F(void, DeleteBuffers, (GLsizei n, const GLuint *buffers)) \
+	F(void, BindBuffer, (GLenum target, GLuint buffer)) \
+	F(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage)) \
+	F(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data)) \
+	F(GLuint, CreateShader, (GLenum type)) \
+	F(void, DeleteShader, (GLuint shader)) \
+	F(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)) \
+	F(void, CompileShader, (GLuint shader)) \
+	F(void, GetShaderiv, (GLuint shader, GLenum pname, GLint *params)) \
+	F(void, GetShaderInfoLog, (GLuint shader, GLsizei size, GLsizei *length, GLchar *log)) \
+	F(GLuint, CreateProgram, ()) \
+	F(void, DeleteProgram, (GLuint program)) \
+	F(void, AttachShader, (GLuint program, GLuint shader)) \
+	F(void, BindAttribLocation, (GLuint program, GLuint index, const GLchar *name)) \
+	F(void, LinkProgram, (GLuint program)) \
+	F(void, GetProgramiv, (GLuint program, GLenum pname, GLint *params)) \
+	F(void, GetProgramInfoLog, (GLuint program, GLsizei size, GLsizei *length, GLchar *log)) \
+	F(void, UseProgram, (GLuint program)) \
+	F(GLint, GetUniformLocation, (GLuint program, const GLchar *name)) \
+	F(void, Uniform1i, (GLint location, GLint value)) \
+	F(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)) \
+	F(void, EnableVertexAttribArray, (GLuint index)) \
+	F(void, DisableVertexAttribArray, (GLuint index)) \
+	F(void, VertexAttribDivisor, (GLuint index, GLuint divisor)) \
+	F(void, DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instances)) \
+	F(void, MultiDrawElements, (GLenum mode, const GLsizei *count, GLenum type, const void *const *indices, GLsizei drawCount)) \
+	F(void, TexImage3D, (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, \
+		GLint border, GLenum format, GLenum type, const void *pixels)) \
+	F(void, TexSubImage3D, (GLenum target, GLint level, GLint x, GLint y, GLint z, GLsizei width, GLsizei height, \
+		GLsizei depth, GLenum format, GLenum type, const void *pixels)) \
+	F(void, GenerateMipmap, (GLenum target)) \
+	F(void *, MapBuffer, (GLenum target, GLenum access)) \
+	F(GLboolean, UnmapBuffer, (GLenum target)) \
+	F(void, GenQueries, (GLsizei n, GLuint *ids)) \
+	F(void, DeleteQueries, (GLsizei n, const GLuint *ids)) \
+	F(void, QueryCounter, (GLuint id, GLenum target)) \
+	F(void, GetQueryObjectiv, (GLuint id, GLenum pname, GLint *params)) \
+	F(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 *params)) \
+	F(void, GetInteger64v, (GLenum pname, GLint64 *data))
+
+namespace GLExt
+{
+#define GLEXT_DECLARE(result, name, parameters) \
+	typedef result (APIENTRY *name##Proc) parameters; \
+	extern name##Proc name;
+	GLEXT_FUNCTIONS(GLEXT_DECLARE)
+#undef GLEXT_DECLARE
+
+	// needs a current context
+	bool load();
+	bool isLoaded();
+	// the platform's wglGetProcAddress / glXGetProcAddress, eglGetProcAddress with GLEXT_EGL
+	void *getProcAddress(const char *name);
+}
@@ -0,0 +1,54 @@
+#include <math.h>
+#include "Kepler.h"
+#include "FastMath.h"
+
+namespace
+{
+	const int BLOCK = 64;
+	const double DEGREE_PER_RADIAN = 180.0 / FastMath::PI;
+}
+
+void Kepler::solve(const double *meanAnomaly, const double *eccentricity, double *eccentricAnomaly, int n,
+	double tolerance, int maxIterations)
+{
+	double M[BLOCK], degree[BLOCK], s[BLOCK], c[BLOCK];
+	for (int begin = 0; begin < n; begin += BLOCK)
+	{
+		int count = n - begin < BLOCK ? n - begin : BLOCK;
+		const double *e = eccentricity + begin;
+		double *E = eccentricAnomaly + begin;
+
+		// reduce to [-pi, pi) and start from M, or from pi for very eccentric orbits
+		for (int i = 0; i < count; ++i)
+		{
+			double m = meanAnomaly[begin + i];
+			m -= 2 * FastMath::PI * floor((m + FastMath::PI) / (2 * FastMath::PI));
+			M[i] = m;
+			E[i] = e[i] > 0.8 ? (m < 0 ? -FastMath::PI : FastMath::PI) : m;
+		}
+
+		for (int iteration = 0; iteration != maxIterations; ++iteration)
+		{
+			for (int i = 0; i < count; ++i)
+				degree[i] = E[i] * DEGREE_PER_RADIAN;
+			FastMath::sinCosDegree(degree, s, c, count);
+			double largest = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				double f = E[i] - e[i] * s[i] - M[i];
+				double step = f / (1.0 - e[i] * c[i]);
+				E[i] -= step;
+				largest = fmax(largest, fabs(step));
+			}
+			if (largest < tolerance)
+				break;
+		}
+	}
+}
+
+double Kepler::solve(double meanAnomaly, double eccentricity)
+{
+	double E;
+	solve(&meanAnomaly, &eccentricity, &E, 1);
+	return E;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Batched solver for Kepler's equation  E - e sin E = M.
+// Newton iterations run over blocks of bodies at once: every iteration is one
+// batched sin/cos (FastMath) and a branch-free update over the block, and the
+// block stops as soon as its largest correction is below the tolerance.
+namespace Kepler
+{
+	// meanAnomaly in radians (any range), 0 <= eccentricity < 1.
+	// writes the eccentric anomaly in radians, for M reduced to [-pi, pi).
+	void solve(const double *meanAnomaly, const double *eccentricity, double *eccentricAnomaly, int n,
+		double tolerance = 1e-12, int maxIterations = 32);
+	double solve(double meanAnomaly, double eccentricity);
+}
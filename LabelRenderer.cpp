@@ -0,0 +1,172 @@
+#include "LabelRenderer.h"
+#include "BmpImage.h"
+#include "GLExtensions.h"
+
+bool LabelRenderer::loadAtlas(const char *path)
+{
+	BmpImage image;
+	if (!image.load(path))
+	{
+		error = image.getError();
+		return false;
+	}
+	// coverage from the red channel; the color comes from glColor
+	int w = image.getWidth(), h = image.getHeight();
+	std::vector<unsigned char> alpha((size_t)w * h);
+	for (size_t i = 0; i != alpha.size(); ++i)
+		alpha[i] = image.getPixels()[3 * i];
+
+	if (atlas == 0)
+		glGenTextures(1, &atlas);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, w, h, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &alpha[0]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	cellWidth = w / COLUMNS;
+	cellHeight = h / ROWS;
+
+	if (buffer == 0 && GLExt::isLoaded())
+		GLExt::GenBuffers(1, &buffer);
+	// the layout depends on the cell size
+	for (size_t i = 0; i != labels.size(); ++i)
+		labels[i].text.clear();
+	return true;
+}
+
+void LabelRenderer::release()
+{
+	if (atlas != 0)
+		glDeleteTextures(1, &atlas);
+	if (buffer != 0)
+		GLExt::DeleteBuffers(1, &buffer);
+	atlas = buffer = 0;
+	bufferCapacity = 0;
+}
+
+void LabelRenderer::setLabel(int id, const char *text)
+{
+	if (id >= (int)labels.size())
+		labels.resize(id + 1);
+	Label &label = labels[id];
+	if (!label.quads.empty() && label.text == text)
+		return;
+	label.text = text;
+	label.quads.clear();
+	// bitmap rows are bottom-up, so the first row of glyphs is at the top
+	float du = 1.0f / COLUMNS, dv = 1.0f / ROWS;
+	for (int k = 0; text[k] != '\0'; ++k)
+	{
+		int c = (unsigned char)text[k];
+		if (c < 32 || c > 127)
+			c = '?';
+		float u = (c - 32) % COLUMNS * du, v = 1.0f - (c - 32) / COLUMNS * dv;
+		float x0 = (float)(k * cellWidth), x1 = x0 + cellWidth, y1 = (float)cellHeight;
+		const float QUAD[4][VERTEX_FLOATS] = {
+			{ x0, 0, u, v - dv }, { x1, 0, u + du, v - dv }, { x1, y1, u + du, v }, { x0, y1, u, v } };
+		label.quads.insert(label.quads.end(), &QUAD[0][0], &QUAD[0][0] + 4 * VERTEX_FLOATS);
+	}
+}
+
+void LabelRenderer::begin(const GLdouble *projection, const GLdouble *modelView, int viewportWidth, int viewportHeight)
+{
+	for (int c = 0; c != 4; ++c)
+		for (int r = 0; r != 4; ++r)
+		{
+			double sum = 0;
+			for (int k = 0; k != 4; ++k)
+				sum += projection[k * 4 + r] * modelView[c * 4 + k];
+			viewProjection[c * 4 + r] = sum;
+		}
+	viewport[0] = viewportWidth;
+	viewport[1] = viewportHeight;
+	batch.clear();
+}
+
+void LabelRenderer::begin(int viewportWidth, int viewportHeight)
+{
+	const GLdouble IDENTITY[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	begin(IDENTITY, IDENTITY, viewportWidth, viewportHeight);
+}
+
+void LabelRenderer::add(int id, double x, double y, double z)
+{
+	const double *m = viewProjection;
+	double w = m[3] * x + m[7] * y + m[11] * z + m[15];
+	if (w <= 0)
+		return;
+	// whole pixels keep the glyphs sharp
+	addAt(id, (int)((m[0] * x + m[4] * y + m[8] * z + m[12]) / w * 0.5 * viewport[0] + 0.5 * viewport[0]),
+		(int)((m[1] * x + m[5] * y + m[9] * z + m[13]) / w * 0.5 * viewport[1] + 0.5 * viewport[1]));
+}
+
+void LabelRenderer::addAt(int id, int x, int y)
+{
+	if (id < 0 || id >= (int)labels.size() || labels[id].quads.empty())
+		return;
+	float sx = (float)x, sy = (float)y;
+	const std::vector<float> &quads = labels[id].quads;
+	size_t first = batch.size();
+	batch.insert(batch.end(), quads.begin(), quads.end());
+	for (size_t i = first; i != batch.size(); i += VERTEX_FLOATS)
+	{
+		batch[i] += sx;
+		batch[i + 1] += sy;
+	}
+}
+
+void LabelRenderer::draw()
+{
+	if (batch.empty() || atlas == 0)
+		return;
+	const float *vertices = &batch[0];
+	if (buffer != 0)
+	{
+		size_t bytes = batch.size() * sizeof(float);
+		GLExt::BindBuffer(GL_ARRAY_BUFFER, buffer);
+		if (bytes > bufferCapacity)
+		{
+			bufferCapacity = bytes * 2;
+			GLExt::BufferData(GL_ARRAY_BUFFER, bufferCapacity, NULL, GL_STREAM_DRAW);
+		}
+		GLExt::BufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices);
+		vertices = NULL; // offsets into the buffer
+	}
+
+	glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+	glColor3f(1, 1, 1);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, viewport[0], 0, viewport[1], -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	GLsizei stride = VERTEX_FLOATS * sizeof(float);
+	glVertexPointer(2, GL_FLOAT, stride, vertices);
+	glTexCoordPointer(2, GL_FLOAT, stride, vertices + 2);
+	glDrawArrays(GL_QUADS, 0, (GLsizei)(batch.size() / VERTEX_FLOATS));
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopAttrib();
+	if (buffer != 0)
+		GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "GLHeaders.h"
+
+// Screen-aligned text labels from a glyph atlas: a bitmap holding the
+// characters 32..127 in a grid of 16 columns and 6 rows, white on black.
+// Each label is laid out once when its text changes; every frame the
+// visible labels are only moved to their anchor, collected into one
+// vertex buffer and drawn with a single call, on top of the scene.
+class LabelRenderer
+{
+public:
+	static const int COLUMNS = 16;
+	static const int ROWS = 6;
+
+	// needs a current context; uses a buffer object when GLExtensions is loaded
+	bool loadAtlas(const char *path);
+	const std::string &getError() const { return error; }
+	void release();
+
+	void setLabel(int id, const char *text);
+	// the matrices of the scene, column-major as from glGetDoublev
+	void begin(const GLdouble *projection, const GLdouble *modelView, int viewportWidth, int viewportHeight);
+	// the label of id next to the world point, unless it is behind the camera
+	void add(int id, double x, double y, double z);
+	// screen text: begin() without matrices, then the label at a window position
+	void begin(int viewportWidth, int viewportHeight);
+	void addAt(int id, int x, int y);
+	int getLineHeight() const { return cellHeight; }
+	void draw();
+	int getGlyphCount() const { return (int)batch.size() / VERTEX_FLOATS / 4; }
+private:
+	static const int VERTEX_FLOATS = 4; // x, y, u, v
+	struct Label
+	{
+		std::string text;
+		std::vector<float> quads; // relative to the anchor
+	};
+
+	GLuint atlas = 0;
+	GLuint buffer = 0;
+	size_t bufferCapacity = 0;
+	int cellWidth = 0;
+	int cellHeight = 0;
+	std::vector<Label> labels; // by id
+	std::vector<float> batch;
+	double viewProjection[16];
+	int viewport[2];
+	std::string error;
+};
@@ -0,0 +1,27 @@
+#include <math.h>
+#include "LevelOfDetail.h"
+#include "FastMath.h"
+
+int LevelOfDetail::select(int body, double pixelRadius)
+{
+	if (body >= (int)current.size())
+		current.resize(body + 1, 0);
+	int level = current[body];
+	int last = (int)thresholds.size();
+	while (level > 0 && pixelRadius > thresholds[level - 1] * (1.0 + hysteresis))
+		--level;
+	while (level < last && pixelRadius < thresholds[level] * (1.0 - hysteresis))
+		++level;
+	current[body] = level;
+	return level;
+}
+
+double LevelOfDetail::projectedRadius(double radius, double distance, double fovyDegree, int viewportHeight)
+{
+	if (distance <= radius)
+		return 1e30; // the camera is inside
+	// angular radius over half the field of view, in half viewport heights
+	double angle = asin(radius / distance);
+	double halfFov = 0.5 * fovyDegree * FastMath::RADIAN_PER_DEGREE;
+	return tan(angle) / tan(halfFov) * 0.5 * viewportHeight;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+// Picks a mesh level per body from its projected radius in pixels.
+// Level 0 is the finest; a body moves to a coarser level when it shrinks
+// below threshold * (1 - hysteresis) and back when it grows above
+// threshold * (1 + hysteresis), so levels do not flicker at a boundary.
+class LevelOfDetail
+{
+public:
+	// thresholds[k] is the pixel radius between level k and k + 1, descending
+	LevelOfDetail(const double *thresholds, int count, double hysteresis = 0.15)
+		: thresholds(thresholds, thresholds + count), hysteresis(hysteresis) {}
+
+	int getLevels() const { return (int)thresholds.size() + 1; }
+	// remembers the level of the body for the next call
+	int select(int body, double pixelRadius);
+
+	// radius of a sphere on screen for a gluPerspective projection
+	static double projectedRadius(double radius, double distance, double fovyDegree, int viewportHeight);
+private:
+	std::vector<double> thresholds;
+	double hysteresis;
+	std::vector<int> current; // by body
+};
@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool MappedFile::open(const char *path)
+{
+	close();
+	HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER length;
+	if (!GetFileSizeEx(f, &length) || length.QuadPart == 0)
+	{
+		CloseHandle(f);
+		return false;
+	}
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void *view = m != NULL ? MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (view == NULL)
+	{
+		if (m != NULL)
+			CloseHandle(m);
+		CloseHandle(f);
+		return false;
+	}
+	file = f;
+	mapping = m;
+	data = (const unsigned char *)view;
+	size = (size_t)length.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data == NULL)
+		return;
+	UnmapViewOfFile(data);
+	CloseHandle(mapping);
+	CloseHandle(file);
+	data = NULL;
+	size = 0;
+}
+#else
+bool MappedFile::open(const char *path)
+{
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps the file
+	if (view == MAP_FAILED)
+		return false;
+	data = (const unsigned char *)view;
+	size = (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data == NULL)
+		return;
+	munmap((void *)data, size);
+	data = NULL;
+	size = 0;
+}
+#endif
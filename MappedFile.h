@@ -0,0 +1,28 @@
+#pragma once
+#include <stddef.h>
+
+// Read-only memory mapping of a whole file (CreateFileMapping or mmap).
+// Pages are loaded by the OS on first touch, so opening is cheap
+// regardless of the file size.
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+	bool open(const char *path);
+	void close();
+	bool isOpen() const { return data != NULL; }
+	const unsigned char *getData() const { return data; }
+	size_t getSize() const { return size; }
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+	const unsigned char *data = NULL;
+	size_t size = 0;
+#ifdef _WIN32
+	void *file = NULL; // HANDLE
+	void *mapping = NULL;
+#endif
+};
@@ -0,0 +1,269 @@
+#include <math.h>
+#include "NBodySimulation.h"
+#include "FastMath.h"
+
+const double NBodySimulation::G = 6.674e-20;
+
+namespace
+{
+	const int MAX_DEPTH = 48; // deeper leaves hold a list of bodies
+}
+
+void NBodySimulation::initialize(BodyStore &store)
+{
+	int n = store.size();
+	x.assign(n, 0); y.assign(n, 0); z.assign(n, 0);
+	vx.assign(n, 0); vy.assign(n, 0); vz.assign(n, 0);
+	ax.assign(n, 0); ay.assign(n, 0); az.assign(n, 0);
+	mass = store.mass;
+
+	// parents come first, so their state is ready
+	for (int i = 0; i != n; ++i)
+	{
+		int p = store.parent[i];
+		double a = store.distanceRevolution[i];
+		double e = store.orbitEccentricity[i];
+		double b = sqrt(1.0 - e * e);
+		double s, c;
+		FastMath::sinCosDegree(store.eccentricAnomaly[i] / FastMath::RADIAN_PER_DEGREE, s, c);
+		double meanMotion = 0; // radian per second
+		if (p >= 0 && a > 0)
+		{
+			if (mass[p] > 0)
+				meanMotion = sqrt(G * mass[p] / (a * a * a));
+			else
+				meanMotion = store.rateRevolution[i] * FastMath::RADIAN_PER_DEGREE / 3600.0;
+		}
+		// position and its time derivative in the orbit plane
+		double xp = a * (c - e), yp = a * b * s;
+		double k = meanMotion * a / (1.0 - e * c);
+		double vxp = -k * s, vyp = k * b * c;
+		x[i] = xp * store.orbitPX[i] + yp * store.orbitQX[i];
+		y[i] = xp * store.orbitPY[i] + yp * store.orbitQY[i];
+		z[i] = xp * store.orbitPZ[i] + yp * store.orbitQZ[i];
+		vx[i] = vxp * store.orbitPX[i] + vyp * store.orbitQX[i];
+		vy[i] = vxp * store.orbitPY[i] + vyp * store.orbitQY[i];
+		vz[i] = vxp * store.orbitPZ[i] + vyp * store.orbitQZ[i];
+		if (p >= 0)
+		{
+			x[i] += x[p]; y[i] += y[p]; z[i] += z[p];
+			vx[i] += vx[p]; vy[i] += vy[p]; vz[i] += vz[p];
+		}
+	}
+
+	// barycentric frame, so the system does not drift away
+	double m = 0, px = 0, py = 0, pz = 0;
+	for (int i = 0; i != n; ++i)
+	{
+		m += mass[i];
+		px += mass[i] * vx[i];
+		py += mass[i] * vy[i];
+		pz += mass[i] * vz[i];
+	}
+	if (m > 0)
+	{
+		for (int i = 0; i != n; ++i)
+		{
+			vx[i] -= px / m;
+			vy[i] -= py / m;
+			vz[i] -= pz / m;
+		}
+	}
+	computeAccelerations();
+}
+
+void NBodySimulation::step(double hours)
+{
+	double dt = hours * 3600.0;
+	double half = 0.5 * dt;
+	int n = size();
+	for (int i = 0; i < n; ++i)
+	{
+		vx[i] += ax[i] * half; vy[i] += ay[i] * half; vz[i] += az[i] * half;
+		x[i] += vx[i] * dt; y[i] += vy[i] * dt; z[i] += vz[i] * dt;
+	}
+	computeAccelerations();
+	for (int i = 0; i < n; ++i)
+	{
+		vx[i] += ax[i] * half; vy[i] += ay[i] * half; vz[i] += az[i] * half;
+	}
+}
+
+void NBodySimulation::writePositions(BodyStore &store) const
+{
+	if (size() == store.size() && size() > 0)
+		store.setWorld(&x[0], &y[0], &z[0], BodyStore::rescaleKm(1.0));
+}
+
+int NBodySimulation::newNode(double cx, double cy, double cz, double half)
+{
+	Node node;
+	node.cx = cx; node.cy = cy; node.cz = cz; node.half = half;
+	node.mass = node.mx = node.my = node.mz = 0;
+	for (int k = 0; k != 8; ++k)
+		node.child[k] = -1;
+	node.body = -1;
+	nodes.push_back(node);
+	return (int)nodes.size() - 1;
+}
+
+void NBodySimulation::buildTree()
+{
+	nodes.clear();
+	massive.clear();
+	for (int i = 0; i != size(); ++i)
+		if (mass[i] > 0)
+			massive.push_back(i);
+	next.assign(size(), -1);
+	if (massive.empty())
+		return;
+
+	double lo[3] = { x[massive[0]], y[massive[0]], z[massive[0]] };
+	double hi[3] = { lo[0], lo[1], lo[2] };
+	for (size_t k = 1; k != massive.size(); ++k)
+	{
+		int i = massive[k];
+		lo[0] = fmin(lo[0], x[i]); hi[0] = fmax(hi[0], x[i]);
+		lo[1] = fmin(lo[1], y[i]); hi[1] = fmax(hi[1], y[i]);
+		lo[2] = fmin(lo[2], z[i]); hi[2] = fmax(hi[2], z[i]);
+	}
+	double half = 0.5 * fmax(hi[0] - lo[0], fmax(hi[1] - lo[1], hi[2] - lo[2])) + 1.0;
+	nodes.reserve(2 * massive.size() + 1);
+	newNode(0.5 * (lo[0] + hi[0]), 0.5 * (lo[1] + hi[1]), 0.5 * (lo[2] + hi[2]), half);
+	for (size_t k = 0; k != massive.size(); ++k)
+		insert(0, massive[k], 0);
+	summarize(0);
+}
+
+void NBodySimulation::insert(int node, int body, int depth)
+{
+	for (;;)
+	{
+		Node &n = nodes[node];
+		bool leaf = (n.body >= 0);
+		bool empty = !leaf;
+		for (int k = 0; k != 8 && empty; ++k)
+			empty = (n.child[k] < 0);
+		if (empty)
+		{
+			n.body = body;
+			return;
+		}
+		if (leaf)
+		{
+			if (depth >= MAX_DEPTH)
+			{
+				next[body] = n.body;
+				n.body = body;
+				return;
+			}
+			// push the resident body one level down
+			int resident = n.body;
+			n.body = -1;
+			insertChild(node, resident, depth);
+		}
+		node = childFor(node, body);
+		++depth;
+	}
+}
+
+int NBodySimulation::childFor(int node, int body)
+{
+	const Node &n = nodes[node];
+	int k = (x[body] >= n.cx ? 1 : 0) | (y[body] >= n.cy ? 2 : 0) | (z[body] >= n.cz ? 4 : 0);
+	if (n.child[k] < 0)
+	{
+		double h = 0.5 * n.half;
+		int c = newNode(n.cx + ((k & 1) ? h : -h), n.cy + ((k & 2) ? h : -h), n.cz + ((k & 4) ? h : -h), h);
+		nodes[node].child[k] = c; // newNode may have moved the nodes
+	}
+	return nodes[node].child[k];
+}
+
+void NBodySimulation::insertChild(int node, int body, int depth)
+{
+	insert(childFor(node, body), body, depth + 1);
+}
+
+void NBodySimulation::summarize(int node)
+{
+	Node &n = nodes[node];
+	double m = 0, mx = 0, my = 0, mz = 0;
+	for (int b = n.body; b >= 0; b = next[b])
+	{
+		m += mass[b];
+		mx += mass[b] * x[b];
+		my += mass[b] * y[b];
+		mz += mass[b] * z[b];
+	}
+	for (int k = 0; k != 8; ++k)
+	{
+		int c = nodes[node].child[k];
+		if (c < 0)
+			continue;
+		summarize(c);
+		const Node &child = nodes[c];
+		m += child.mass;
+		mx += child.mass * child.mx;
+		my += child.mass * child.my;
+		mz += child.mass * child.mz;
+	}
+	Node &done = nodes[node];
+	done.mass = m;
+	if (m > 0)
+	{
+		done.mx = mx / m;
+		done.my = my / m;
+		done.mz = mz / m;
+	}
+}
+
+void NBodySimulation::accelerate(int body, double &gx, double &gy, double &gz) const
+{
+	gx = gy = gz = 0;
+	if (nodes.empty())
+		return;
+	double eps2 = softening * softening;
+	double theta2 = theta * theta;
+	int stack[8 * MAX_DEPTH + 8];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
+	{
+		const Node &n = nodes[stack[--top]];
+		if (n.body >= 0)
+		{
+			for (int b = n.body; b >= 0; b = next[b])
+			{
+				if (b == body)
+					continue;
+				double dx = x[b] - x[body], dy = y[b] - y[body], dz = z[b] - z[body];
+				double d2 = dx * dx + dy * dy + dz * dz + eps2;
+				double f = G * mass[b] / (d2 * sqrt(d2));
+				gx += f * dx; gy += f * dy; gz += f * dz;
+			}
+			continue;
+		}
+		double dx = n.mx - x[body], dy = n.my - y[body], dz = n.mz - z[body];
+		double d2 = dx * dx + dy * dy + dz * dz + eps2;
+		double size = 2 * n.half;
+		if (size * size < theta2 * d2)
+		{
+			double f = G * n.mass / (d2 * sqrt(d2));
+			gx += f * dx; gy += f * dy; gz += f * dz;
+			continue;
+		}
+		for (int k = 0; k != 8; ++k)
+			if (n.child[k] >= 0)
+				stack[top++] = n.child[k];
+	}
+}
+
+void NBodySimulation::computeAccelerations()
+{
+	buildTree();
+	pool.parallelFor(size(), 256, [this](int begin, int end) {
+		for (int i = begin; i != end; ++i)
+			accelerate(i, ax[i], ay[i], az[i]);
+	});
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include "BodyStore.h"
+#include "ThreadPool.h"
+
+// Mutual gravity between the bodies of a BodyStore, integrated with a
+// kick-drift-kick leapfrog. Accelerations come from a Barnes-Hut octree over
+// the bodies that have mass; bodies without mass are test particles that
+// feel gravity but do not pull on anything. The force pass is split across
+// the thread pool.
+//
+// Units are km, kg and seconds.
+class NBodySimulation
+{
+public:
+	NBodySimulation(ThreadPool &pool) : pool(pool) {}
+
+	// Initial conditions from the orbit model at the store's epoch, using
+	// the real (km) orbit distances. Each body starts on its Keplerian orbit
+	// around its parent. The system is moved to its barycentric frame.
+	void initialize(BodyStore &store);
+	void step(double hours);
+	// writes the positions into the store's world position cache
+	void writePositions(BodyStore &store) const;
+
+	int size() const { return (int)x.size(); }
+	void setTheta(double theta) { this->theta = theta; }
+	void setSoftening(double softening) { this->softening = softening; }
+
+	std::vector<double> x, y, z; // km
+	std::vector<double> vx, vy, vz; // km/s
+	std::vector<double> ax, ay, az; // km/s^2
+	std::vector<double> mass; // kg
+
+	static const double G; // km^3 / (kg s^2)
+private:
+	struct Node
+	{
+		double cx, cy, cz, half; // cube
+		double mass, mx, my, mz; // total mass and centre of mass
+		int child[8]; // -1 if empty
+		int body; // body in a leaf, -1 for an inner node
+	};
+	ThreadPool &pool;
+	std::vector<Node> nodes;
+	std::vector<int> massive; // bodies in the tree
+	std::vector<int> next; // next body in the same leaf, -1 at the end
+	double theta = 0.5; // opening angle
+	double softening = 1.0; // km
+
+	void buildTree();
+	int newNode(double cx, double cy, double cz, double half);
+	void insert(int node, int body, int depth);
+	void insertChild(int node, int body, int depth);
+	int childFor(int node, int body);
+	void summarize(int node);
+	void accelerate(int body, double &gx, double &gy, double &gz) const;
+	void computeAccelerations();
+};
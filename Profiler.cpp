@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <string.h>
+#include "Profiler.h"
+#include "GLExtensions.h"
+
+Profiler::Profiler()
+	: enabled(false), slots(new Slot[CAPACITY]), head(0), epoch(std::chrono::steady_clock::now())
+{
+	for (int i = 0; i != CAPACITY; ++i)
+		slots[i].sequence.store(-1, std::memory_order_relaxed);
+}
+
+long long Profiler::now() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+int Profiler::threadNumber()
+{
+	static std::atomic<int> threads(0);
+	static thread_local int number = threads.fetch_add(1);
+	return number;
+}
+
+void Profiler::record(const char *name, Kind kind, long long start, long long duration)
+{
+	long long index = head.fetch_add(1, std::memory_order_relaxed);
+	Slot &slot = slots[index & (CAPACITY - 1)];
+	slot.sequence.store(-1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Event event = { name, start, duration, threadNumber(), kind };
+	slot.event = event;
+	slot.sequence.store(index, std::memory_order_release);
+}
+
+void Profiler::snapshot(std::vector<Event> &events) const
+{
+	events.clear();
+	long long end = head.load(std::memory_order_acquire);
+	long long begin = end > CAPACITY ? end - CAPACITY : 0;
+	for (long long index = begin; index != end; ++index)
+	{
+		const Slot &slot = slots[index & (CAPACITY - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != index)
+			continue; // still being written, or already overwritten
+		Event event = slot.event;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == index)
+			events.push_back(event);
+	}
+}
+
+void Profiler::summarize(double seconds, std::vector<Summary> &summaries) const
+{
+	std::vector<Event> events;
+	snapshot(events);
+	long long from = now() - (long long)(seconds * 1e9);
+	summaries.clear();
+	for (size_t e = 0; e != events.size(); ++e)
+	{
+		const Event &event = events[e];
+		if (event.start < from)
+			continue;
+		size_t s = 0;
+		while (s != summaries.size() && (summaries[s].kind != event.kind || strcmp(summaries[s].name, event.name) != 0))
+			++s;
+		if (s == summaries.size())
+		{
+			Summary summary = { event.name, event.kind, 0, 0, 0 };
+			summaries.push_back(summary);
+		}
+		Summary &summary = summaries[s];
+		double ms = event.duration / 1e6;
+		summary.averageMs += (ms - summary.averageMs) / ++summary.count;
+		if (ms > summary.maxMs)
+			summary.maxMs = ms;
+	}
+}
+
+bool Profiler::writeTrace(const char *path) const
+{
+	std::vector<Event> events;
+	snapshot(events);
+	FILE *file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t e = 0; e != events.size(); ++e)
+	{
+		const Event &event = events[e];
+		// GPU events get a track of their own
+		fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d},\n",
+			event.name, event.kind == GPU ? "gpu" : "cpu", event.start / 1e3, event.duration / 1e3,
+			event.kind == GPU ? 1000 : event.thread);
+	}
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1000,\"args\":{\"name\":\"GPU\"}}\n]}\n");
+	return fclose(file) == 0;
+}
+
+void Profiler::initializeGpu()
+{
+	releaseGpu();
+	if (!GLExt::isLoaded())
+		return;
+	queries.resize(2 * GPU_QUERIES);
+	GLExt::GenQueries((GLsizei)queries.size(), &queries[0]);
+	nextQuery = queriesInFlight = 0;
+	GLint64 gpuNow = 0;
+	GLExt::GetInteger64v(GL_TIMESTAMP, &gpuNow);
+	gpuOffset = now() - gpuNow;
+}
+
+void Profiler::releaseGpu()
+{
+	if (!queries.empty())
+		GLExt::DeleteQueries((GLsizei)queries.size(), &queries[0]);
+	queries.clear();
+	pending.clear();
+}
+
+int Profiler::beginGpu()
+{
+	if (queries.empty() || queriesInFlight == GPU_QUERIES)
+		return -1; // no timer queries, or the GPU is far behind
+	int query = nextQuery;
+	nextQuery = (nextQuery + 2) % (int)queries.size();
+	++queriesInFlight;
+	GLExt::QueryCounter(queries[query], GL_TIMESTAMP);
+	return query;
+}
+
+void Profiler::endGpu(int query, const char *name)
+{
+	GLExt::QueryCounter(queries[query + 1], GL_TIMESTAMP);
+	PendingQuery p = { name, query };
+	pending.push_back(p);
+}
+
+void Profiler::endFrame()
+{
+	// queries finish in order, so stop at the first that is not ready
+	while (!pending.empty())
+	{
+		const PendingQuery &p = pending.front();
+		GLint available = 0;
+		GLExt::GetQueryObjectiv(queries[p.query + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			break;
+		GLuint64 begin = 0, end = 0;
+		GLExt::GetQueryObjectui64v(queries[p.query], GL_QUERY_RESULT, &begin);
+		GLExt::GetQueryObjectui64v(queries[p.query + 1], GL_QUERY_RESULT, &end);
+		record(p.name, GPU, (long long)begin + gpuOffset, (long long)(end - begin));
+		pending.pop_front();
+		--queriesInFlight;
+	}
+	if (!queries.empty() && isEnabled())
+	{
+		// the clocks drift apart slowly; follow them
+		GLint64 gpuNow = 0;
+		GLExt::GetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuOffset = now() - gpuNow;
+	}
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "GLHeaders.h"
+
+// Frame profiler: named CPU scopes and GPU timer queries, recorded into a
+// fixed ring that any thread writes without locks. Each slot carries a
+// sequence number, written last, so a reader copying the ring can tell
+// a finished event from one being overwritten. GPU scopes are pairs of
+// timestamp queries; endFrame() collects the finished ones without
+// waiting and moves them onto the CPU timeline. While disabled a scope
+// costs one relaxed atomic load.
+class Profiler
+{
+public:
+	enum Kind { CPU, GPU };
+	struct Event
+	{
+		const char *name; // a string literal
+		long long start; // ns since the profiler was created
+		long long duration; // ns
+		int thread; // small number per thread, 0 for the first one seen
+		int kind;
+	};
+	struct Summary
+	{
+		const char *name;
+		int kind;
+		int count;
+		double averageMs;
+		double maxMs;
+	};
+
+	// times one block on the calling thread
+	class Scope
+	{
+	public:
+		Scope(Profiler &profiler, const char *name)
+			: profiler(profiler.isEnabled() ? &profiler : NULL), name(name), start(this->profiler ? profiler.now() : 0) {}
+		~Scope()
+		{
+			if (profiler != NULL)
+				profiler->record(name, CPU, start, profiler->now() - start);
+		}
+	private:
+		Profiler *profiler;
+		const char *name;
+		long long start;
+	};
+	// times the GL commands issued in one block; on the GL thread
+	class GpuScope
+	{
+	public:
+		GpuScope(Profiler &profiler, const char *name)
+			: profiler(profiler.isEnabled() ? &profiler : NULL), query(this->profiler ? profiler.beginGpu() : -1), name(name) {}
+		~GpuScope()
+		{
+			if (query >= 0)
+				profiler->endGpu(query, name);
+		}
+	private:
+		Profiler *profiler;
+		int query;
+		const char *name;
+	};
+
+	static const int CAPACITY = 1 << 14; // events, a power of two
+
+	Profiler();
+
+	void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+	// needs a current context; without timer queries GPU scopes record nothing
+	void initializeGpu();
+	void releaseGpu();
+
+	long long now() const;
+	void record(const char *name, Kind kind, long long start, long long duration);
+	// collects finished GPU queries; once per frame on the GL thread
+	void endFrame();
+
+	// the events still in the ring, oldest first
+	void snapshot(std::vector<Event> &events) const;
+	// per name and kind, over the events of the last seconds
+	void summarize(double seconds, std::vector<Summary> &summaries) const;
+	// Chrome trace event format, for chrome://tracing or Perfetto
+	bool writeTrace(const char *path) const;
+private:
+	Profiler(const Profiler &);
+	Profiler &operator=(const Profiler &);
+
+	struct Slot
+	{
+		std::atomic<long long> sequence; // index of the event, -1 while written
+		Event event;
+	};
+	struct PendingQuery
+	{
+		const char *name;
+		int query; // first of a pair of queries
+	};
+	static const int GPU_QUERIES = 512; // pairs in flight
+
+	int beginGpu();
+	void endGpu(int query, const char *name);
+	static int threadNumber();
+
+	std::atomic<bool> enabled;
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<long long> head; // events ever recorded
+	std::chrono::steady_clock::time_point epoch;
+
+	// GL thread only
+	std::vector<GLuint> queries;
+	int nextQuery = 0;
+	int queriesInFlight = 0;
+	std::deque<PendingQuery> pending;
+	long long gpuOffset = 0; // profiler time minus GPU time
+};
@@ -0,0 +1,49 @@
+#include <algorithm>
+#include "RenderQueue.h"
+
+namespace
+{
+	// bits per field, from the top of the key
+	const int SHADER_BITS = 8;
+	const int MATERIAL_BITS = 12;
+	const int TEXTURE_BITS = 24;
+	const int LEVEL_BITS = 8;
+
+	unsigned long long field(int value, int bits)
+	{
+		return (unsigned long long)value & ((1ULL << bits) - 1);
+	}
+
+	bool before(const RenderQueue::Item &a, const RenderQueue::Item &b)
+	{
+		return a.key != b.key ? a.key < b.key : a.body < b.body;
+	}
+}
+
+void RenderQueue::add(int shader, int material, int texture, int level, int body)
+{
+	Item item;
+	item.key = field(shader, SHADER_BITS) << (MATERIAL_BITS + TEXTURE_BITS + LEVEL_BITS)
+		| field(material, MATERIAL_BITS) << (TEXTURE_BITS + LEVEL_BITS)
+		| field(texture + 1, TEXTURE_BITS) << LEVEL_BITS
+		| field(level, LEVEL_BITS);
+	item.shader = shader;
+	item.material = material;
+	item.texture = texture;
+	item.level = level;
+	item.body = body;
+	items.push_back(item);
+}
+
+void RenderQueue::sort()
+{
+	std::sort(items.begin(), items.end(), before);
+}
+
+int RenderQueue::endOfRun(int first) const
+{
+	int end = first;
+	while (end != (int)items.size() && items[end].shader == items[first].shader && items[end].material == items[first].material)
+		++end;
+	return end;
+}
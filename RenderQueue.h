@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+// The bodies to draw in one frame, sorted so that bodies sharing state are
+// drawn one after another. The sort key packs, most significant first, the
+// shader, the material, the texture and the mesh level: the costlier a
+// change, the fewer times sorting lets it happen.
+class RenderQueue
+{
+public:
+	struct Item
+	{
+		unsigned long long key;
+		int shader;
+		int material;
+		int texture; // -1 for none
+		int level;
+		int body;
+	};
+
+	void clear() { items.clear(); }
+	void add(int shader, int material, int texture, int level, int body);
+	// by key, then by body so the order is stable from frame to frame
+	void sort();
+
+	int size() const { return (int)items.size(); }
+	const Item &operator[](int i) const { return items[i]; }
+	// the end of the run of items from first on with the same shader and material
+	int endOfRun(int first) const;
+private:
+	std::vector<Item> items;
+};
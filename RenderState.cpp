@@ -0,0 +1,169 @@
+#include <string.h>
+#include "RenderState.h"
+#include "GLExtensions.h"
+
+void RenderState::invalidate()
+{
+	for (size_t c = 0; c != capabilities.size(); ++c)
+		capabilities[c].on = -1;
+	program = 0;
+	programKnown = false;
+	invalidateTextures();
+	material = NULL;
+	for (int l = 0; l != LIGHTS; ++l)
+		lightColorsKnown[l] = lightPositionKnown[l] = false;
+	perspectiveKnown = false;
+	beginFrame();
+}
+
+void RenderState::invalidateTextures()
+{
+	unit = -1;
+	for (int u = 0; u != TEXTURE_UNITS; ++u)
+		bindings[u].clear();
+}
+
+void RenderState::beginFrame()
+{
+	Stats empty = {};
+	stats = empty;
+}
+
+int RenderState::getChanges() const
+{
+	return stats.programs + stats.textures + stats.materials + stats.lights + stats.capabilities + stats.projections;
+}
+
+void RenderState::enable(GLenum capability, bool on)
+{
+	size_t c = 0;
+	while (c != capabilities.size() && capabilities[c].name != capability)
+		++c;
+	if (c == capabilities.size())
+	{
+		Capability unknown = { capability, -1 };
+		capabilities.push_back(unknown);
+	}
+	if (capabilities[c].on == (on ? 1 : 0))
+	{
+		++stats.skipped;
+		return;
+	}
+	if (on)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	capabilities[c].on = on ? 1 : 0;
+	++stats.capabilities;
+}
+
+void RenderState::useProgram(GLuint newProgram)
+{
+	if (programKnown && program == newProgram)
+	{
+		++stats.skipped;
+		return;
+	}
+	if (GLExt::isLoaded())
+		GLExt::UseProgram(newProgram);
+	program = newProgram;
+	programKnown = true;
+	++stats.programs;
+}
+
+void RenderState::activeTexture(int newUnit)
+{
+	if (unit == newUnit)
+		return;
+	if (GLExt::isLoaded())
+		GLExt::ActiveTexture(GL_TEXTURE0 + newUnit);
+	unit = newUnit;
+	++stats.textures;
+}
+
+void RenderState::bindTexture(int textureUnit, GLenum target, GLuint texture)
+{
+	std::vector<Binding> &bound = bindings[textureUnit];
+	size_t b = 0;
+	while (b != bound.size() && bound[b].target != target)
+		++b;
+	if (b != bound.size() && bound[b].texture == texture)
+	{
+		++stats.skipped;
+		return;
+	}
+	activeTexture(textureUnit);
+	glBindTexture(target, texture);
+	if (b == bound.size())
+	{
+		Binding binding = { target, texture };
+		bound.push_back(binding);
+	}
+	bound[b].texture = texture;
+	++stats.textures;
+}
+
+void RenderState::setMaterial(const Material *newMaterial)
+{
+	if (material == newMaterial)
+	{
+		++stats.skipped;
+		return;
+	}
+	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, newMaterial->ambient);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, newMaterial->diffuse);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, newMaterial->specular);
+	glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, newMaterial->shininess);
+	material = newMaterial;
+	++stats.materials;
+}
+
+void RenderState::setLightColors(int light, const GLfloat *ambient, const GLfloat *diffuse, const GLfloat *specular)
+{
+	GLfloat colors[12];
+	memcpy(colors, ambient, 4 * sizeof(GLfloat));
+	memcpy(colors + 4, diffuse, 4 * sizeof(GLfloat));
+	memcpy(colors + 8, specular, 4 * sizeof(GLfloat));
+	if (lightColorsKnown[light] && memcmp(colors, lightColors[light], sizeof(colors)) == 0)
+	{
+		++stats.skipped;
+		return;
+	}
+	glLightfv(GL_LIGHT0 + light, GL_AMBIENT, ambient);
+	glLightfv(GL_LIGHT0 + light, GL_DIFFUSE, diffuse);
+	glLightfv(GL_LIGHT0 + light, GL_SPECULAR, specular);
+	memcpy(lightColors[light], colors, sizeof(colors));
+	lightColorsKnown[light] = true;
+	++stats.lights;
+}
+
+void RenderState::setLightPosition(int light, const GLfloat *position, const GLdouble *view)
+{
+	if (lightPositionKnown[light] && memcmp(position, lightPosition[light], 4 * sizeof(GLfloat)) == 0
+		&& memcmp(view, lightView[light], 16 * sizeof(GLdouble)) == 0)
+	{
+		++stats.skipped;
+		return;
+	}
+	glLightfv(GL_LIGHT0 + light, GL_POSITION, position);
+	memcpy(lightPosition[light], position, 4 * sizeof(GLfloat));
+	memcpy(lightView[light], view, 16 * sizeof(GLdouble));
+	lightPositionKnown[light] = true;
+	++stats.lights;
+}
+
+void RenderState::setPerspective(double fovy, double aspect, double zNear, double zFar)
+{
+	double requested[4] = { fovy, aspect, zNear, zFar };
+	if (perspectiveKnown && memcmp(requested, perspective, sizeof(perspective)) == 0)
+	{
+		++stats.skipped;
+		return;
+	}
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	gluPerspective(fovy, aspect, zNear, zFar);
+	memcpy(perspective, requested, sizeof(perspective));
+	perspectiveKnown = true;
+	++stats.projections;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include "GLHeaders.h"
+
+// A cache of the GL state the scene changes while drawing. Every request
+// is compared with the last value issued and only reaches GL when it
+// differs; the counters tell, per frame, how many changes were issued and
+// how many were skipped. Code that changes the same state behind the
+// cache's back must restore it (glPushAttrib) or call invalidate().
+class RenderState
+{
+public:
+	struct Material
+	{
+		GLfloat ambient[4];
+		GLfloat diffuse[4];
+		GLfloat specular[4];
+		GLfloat shininess;
+	};
+	struct Stats
+	{
+		int programs;
+		int textures; // binds, including active unit switches
+		int materials;
+		int lights;
+		int capabilities;
+		int projections;
+		int skipped; // requests that matched the current state
+		int drawCalls;
+	};
+	static const int TEXTURE_UNITS = 2;
+	static const int LIGHTS = 2;
+
+	RenderState() { invalidate(); }
+
+	// the state of the context is unknown; the next request of each kind is issued
+	void invalidate();
+	void invalidateTextures();
+	// clears the counters
+	void beginFrame();
+	const Stats &getStats() const { return stats; }
+	int getChanges() const;
+
+	void enable(GLenum capability, bool on);
+	void useProgram(GLuint program); // 0 for the fixed-function pipeline
+	void bindTexture(int unit, GLenum target, GLuint texture);
+	void activeTexture(int unit);
+	// compared by address: materials live in a table for the life of the scene
+	void setMaterial(const Material *material);
+	void setLightColors(int light, const GLfloat *ambient, const GLfloat *diffuse, const GLfloat *specular);
+	// positions are transformed by the modelview matrix when they are given,
+	// so they are issued again when the view (column major) changes
+	void setLightPosition(int light, const GLfloat *position, const GLdouble *view);
+	// replaces the projection matrix, as gluPerspective
+	void setPerspective(double fovy, double aspect, double zNear, double zFar);
+	void addDrawCalls(int calls) { stats.drawCalls += calls; }
+private:
+	struct Capability
+	{
+		GLenum name;
+		int on; // -1 unknown
+	};
+	struct Binding
+	{
+		GLenum target;
+		GLuint texture;
+	};
+
+	std::vector<Capability> capabilities;
+	GLuint program;
+	bool programKnown;
+	int unit; // active, -1 unknown
+	std::vector<Binding> bindings[TEXTURE_UNITS]; // per target
+	const Material *material;
+	GLfloat lightColors[LIGHTS][12];
+	bool lightColorsKnown[LIGHTS];
+	GLfloat lightPosition[LIGHTS][4];
+	GLdouble lightView[LIGHTS][16];
+	bool lightPositionKnown[LIGHTS];
+	double perspective[4];
+	bool perspectiveKnown;
+	Stats stats;
+};
@@ -0,0 +1,618 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Scene.h"
+#include "AstronomicalObject.h"
+
+const double Scene::FIELD_OF_VIEW = 60.0;
+
+namespace
+{
+	const double PI = 3.141593;
+	const double PHI_UPPER_BOUND = 170.0 * PI / 180.0;
+	const double PHI_LOWER_BOUND = 10.0 * PI / 180.0;
+
+	const int TEXTURE_LAYER_WIDTH = 1024;
+	const int TEXTURE_LAYER_HEIGHT = 512;
+	const int TEXTURE_BUDGET_MB = 64;
+	const int TEXTURE_UPLOADS_PER_FRAME = 2;
+	const int TEXTURE_PLACEHOLDER_WIDTH = 64;
+
+	const int SPHERE_MESHES = 4;
+	const int SPHERE_DIVISIONS[SPHERE_MESHES][2] = { { 64, 32 }, { 36, 18 }, { 16, 8 }, { 8, 4 } };
+	const double LOD_THRESHOLDS[SPHERE_MESHES] = { 150.0, 40.0, 10.0, 2.5 };
+
+	const int TRAIL_LENGTH = 256; // samples
+	const double TRAIL_INTERVAL = 24.0; // simulated hours
+	const float TRAIL_COLOR[4] = { 0.5f, 0.7f, 1.0f, 0.8f };
+
+	const double PICK_PIXELS = 4.0; // least radius of a body to click on
+
+	// render queue keys
+	enum { SHADER_INSTANCED, SHADER_FIXED };
+	enum { MATERIAL_SILVER };
+	const RenderState::Material MATERIALS[] = {
+		{ { 0.19225f, 0.19225f, 0.19225f, 1.0f }, { 0.50754f, 0.50754f, 0.50754f, 1.0f }, { 0.508273f, 0.508273f, 0.508273f, 1.0f }, 0.4f },
+	};
+}
+
+Scene::Scene(ThreadPool &pool)
+	: pool(pool),
+	simulation(pool),
+	camPhi(90.0 * PI / 180.0),
+	textureBudgetMB(TEXTURE_BUDGET_MB),
+	levelOfDetail(LOD_THRESHOLDS, SPHERE_MESHES),
+	trailLength(TRAIL_LENGTH),
+	trailInterval(TRAIL_INTERVAL)
+{
+	for (int level = 0; level != SPHERE_MESHES; ++level)
+		sphereMeshes.push_back(SphereMesh(SPHERE_DIVISIONS[level][0], SPHERE_DIVISIONS[level][1]));
+	viewport[0] = viewport[1] = 1;
+	for (int k = 0; k != 16; ++k)
+		viewMatrix[k] = k % 5 == 0 ? 1.0 : 0.0;
+	lightEnabled[0] = lightEnabled[1] = true;
+}
+
+bool Scene::load(const char *path)
+{
+	if (!catalog.load(path, simulation.getStore()))
+	{
+		error = catalog.getError();
+		return false;
+	}
+	renderStore = simulation.getStore();
+	simulation.reset();
+	catalogPath = path;
+	textureCachePath = catalogPath + ".textures";
+	pool.submit([this]() { prepareTextures(); });
+	return true;
+}
+
+void Scene::initializeGraphics()
+{
+	// a new context: nothing of it is known
+	renderState.invalidate();
+	renderState.enable(GL_DEPTH_TEST, true);
+	renderState.enable(GL_LIGHTING, true);
+	renderState.enable(GL_CULL_FACE, false);
+	glCullFace(GL_BACK);
+	glShadeModel(GL_SMOOTH);
+	renderState.enable(GL_NORMALIZE, true);
+	renderState.enable(GL_TEXTURE_2D, true);
+	if (!sphereRenderer.initialize(&sphereMeshes[0], SPHERE_MESHES))
+		fprintf(stderr, "instanced drawing disabled: %s\n", sphereRenderer.getError().c_str());
+	if (!trails.initialize(catalog.size(), trailLength))
+		fprintf(stderr, "trails disabled: %s\n", trails.getError().c_str());
+	trails.setColor(TRAIL_COLOR[0], TRAIL_COLOR[1], TRAIL_COLOR[2], TRAIL_COLOR[3]);
+	trailSequence = -1;
+	loadTextures();
+	if (labels.loadAtlas("texture_font.bmp"))
+		for (int i = 0; i != catalog.size(); ++i)
+			labels.setLabel(i, catalog.getName(i));
+	else
+		fprintf(stderr, "texture_font.bmp: %s\n", labels.getError().c_str());
+	overlay.loadAtlas("texture_font.bmp");
+	profiler.initializeGpu();
+	renderState.invalidateTextures(); // the uploads above
+}
+
+void Scene::update(double seconds)
+{
+	Profiler::Scope scope(profiler, "simulation");
+	simulation.update(seconds);
+}
+
+bool Scene::isAnimating() const
+{
+	return !simulation.isPaused() || simulation.hasPendingRequests() || simulation.hasNewSnapshot()
+		|| interpolating || textureResidency.getStats().pending > 0;
+}
+
+void Scene::applySnapshot()
+{
+	if (simulation.hasNewSnapshot())
+	{
+		previousSnapshot = simulation.getSnapshot();
+		simulation.takeSnapshot();
+	}
+	const BodySnapshot &latest = simulation.getSnapshot();
+	const BodySnapshot &previous = previousSnapshot;
+	int n = renderStore.size();
+	if ((int)latest.x.size() != n)
+		return; // nothing published yet
+
+	// from the previous snapshot at the time the latest was published to
+	// the latest one interval later; the picture lags by that interval
+	double alpha = 1;
+	interpolating = false;
+	if (interpolation && simulation.isRunning() && (int)previous.x.size() == n
+		&& previous.sequence < latest.sequence && previous.sequence >= latest.lastJump)
+	{
+		double interval = latest.realTime - previous.realTime;
+		if (interval > 0)
+			alpha = (Simulation::realSeconds() - latest.realTime) / interval;
+		if (alpha > 1)
+			alpha = 1;
+		interpolating = alpha < 1;
+	}
+	shownX.resize(n);
+	shownY.resize(n);
+	shownZ.resize(n);
+	for (int i = 0; i != n; ++i)
+	{
+		if (alpha < 1)
+		{
+			shownX[i] = previous.x[i] + (latest.x[i] - previous.x[i]) * alpha;
+			shownY[i] = previous.y[i] + (latest.y[i] - previous.y[i]) * alpha;
+			shownZ[i] = previous.z[i] + (latest.z[i] - previous.z[i]) * alpha;
+			// the short way around
+			double revolution = fmod(latest.angleRevolution[i] - previous.angleRevolution[i] + 540.0, 360.0) - 180.0;
+			double rotation = fmod(latest.angleRotation[i] - previous.angleRotation[i] + 540.0, 360.0) - 180.0;
+			renderStore.angleRevolution[i] = previous.angleRevolution[i] + revolution * alpha;
+			renderStore.angleRotation[i] = previous.angleRotation[i] + rotation * alpha;
+		}
+		else
+		{
+			shownX[i] = latest.x[i];
+			shownY[i] = latest.y[i];
+			shownZ[i] = latest.z[i];
+			renderStore.angleRevolution[i] = latest.angleRevolution[i];
+			renderStore.angleRotation[i] = latest.angleRotation[i];
+		}
+	}
+	renderStore.setWorld(&shownX[0], &shownY[0], &shownZ[0], 1.0);
+	if (trailsShown)
+		sampleTrails();
+}
+
+void Scene::sampleTrails()
+{
+	// the snapshot positions themselves, not the interpolated ones: every
+	// sample lies on the path the simulation computed
+	const BodySnapshot &latest = simulation.getSnapshot();
+	if (latest.sequence == trailSequence)
+		return;
+	if (latest.lastJump > trailSequence)
+		trails.clear(); // the path does not lead here
+	else if (trails.getSamples() > 0 && fabs(latest.time - trailTime) < trailInterval)
+		return;
+	trails.append(&latest.x[0], &latest.y[0], &latest.z[0]);
+	trailTime = latest.time;
+	trailSequence = latest.sequence;
+}
+
+void Scene::setTrails(bool shown)
+{
+	trailsShown = shown;
+	trails.clear();
+	trailSequence = -1;
+}
+
+void Scene::setTrail(int body, bool shown)
+{
+	if (trails.isReady() && body >= 0 && body < renderStore.size())
+		trails.setEnabled(body, shown);
+}
+
+void Scene::render(int width, int height)
+{
+	viewport[0] = width > 0 ? width : 1;
+	viewport[1] = height > 0 ? height : 1;
+	renderState.beginFrame();
+	applySnapshot();
+	{
+		Profiler::Scope scope(profiler, "pickRefit");
+		picker.refit(renderStore);
+	}
+	glViewport(0, 0, viewport[0], viewport[1]);
+	glClearColor(0.1, 0.1, 0.1, 1);
+	glClearDepth(1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	setupProjection(viewport[0], viewport[1]);
+	setupViewing();
+	{
+		Profiler::Scope scope(profiler, "setupLighting");
+		setupLighting();
+	}
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	drawBodies();
+	glPopMatrix();
+	if (profileOverlay)
+		drawProfileOverlay();
+}
+
+void Scene::setProfileOverlay(bool shown)
+{
+	profileOverlay = shown;
+	profiler.setEnabled(shown);
+	overlayUpdated = 0;
+}
+
+void Scene::drawProfileOverlay()
+{
+	const long long UPDATE_NS = 500000000; // the text is laid out twice a second
+	if (overlayUpdated == 0 || profiler.now() - overlayUpdated > UPDATE_NS)
+	{
+		overlayUpdated = profiler.now();
+		std::vector<Profiler::Summary> summaries;
+		profiler.summarize(1.0, summaries);
+		overlay.setLabel(0, "phase            cpu ms  gpu ms");
+		overlayLines = 1;
+		for (size_t s = 0; s != summaries.size(); ++s)
+		{
+			if (summaries[s].kind != Profiler::CPU)
+				continue;
+			double gpu = -1;
+			for (size_t g = 0; g != summaries.size(); ++g)
+				if (summaries[g].kind == Profiler::GPU && strcmp(summaries[g].name, summaries[s].name) == 0)
+					gpu = summaries[g].averageMs;
+			char line[64];
+			if (gpu >= 0)
+				snprintf(line, sizeof(line), "%-16s %6.2f  %6.2f", summaries[s].name, summaries[s].averageMs, gpu);
+			else
+				snprintf(line, sizeof(line), "%-16s %6.2f       -", summaries[s].name, summaries[s].averageMs);
+			overlay.setLabel(overlayLines++, line);
+		}
+	}
+	overlay.begin(viewport[0], viewport[1]);
+	for (int line = 0; line != overlayLines; ++line)
+		overlay.addAt(line, 8, viewport[1] - (line + 1) * overlay.getLineHeight());
+	// fixed function, on unit 0; its own state is pushed and popped
+	renderState.useProgram(0);
+	renderState.activeTexture(0);
+	overlay.draw();
+	renderState.addDrawCalls(1);
+}
+
+void Scene::saveCheckpoint(Checkpoint &checkpoint)
+{
+	checkpoint.begin(renderStore.size());
+	checkpoint.write<double>(camTheta);
+	checkpoint.write<double>(camPhi);
+	checkpoint.write<double>(camDistance);
+	checkpoint.write<int32_t>(viewObject);
+	checkpoint.write<uint8_t>(lightEnabled[0]);
+	checkpoint.write<uint8_t>(lightEnabled[1]);
+	simulation.save(checkpoint);
+}
+
+bool Scene::restoreCheckpoint(Checkpoint &checkpoint)
+{
+	double theta = 0, phi = 0, distance = 0;
+	int32_t body = 0;
+	uint8_t light[2] = { 0, 0 };
+	if (checkpoint.beginRead(renderStore.size()))
+	{
+		checkpoint.read(theta);
+		checkpoint.read(phi);
+		checkpoint.read(distance);
+		checkpoint.read(body);
+		checkpoint.read(light[0]);
+		checkpoint.read(light[1]);
+	}
+	if (!checkpoint.getError().empty() || body < 0 || body >= renderStore.size() || !simulation.restore(checkpoint))
+	{
+		error = checkpoint.getError().empty() ? "corrupt checkpoint" : checkpoint.getError();
+		return false;
+	}
+	camTheta = theta;
+	camPhi = phi;
+	camDistance = distance;
+	viewObject = body;
+	lightEnabled[0] = light[0] != 0;
+	lightEnabled[1] = light[1] != 0;
+	return true;
+}
+
+void Scene::setViewObject(int body)
+{
+	if (body >= 0 && body < renderStore.size())
+		viewObject = body;
+}
+
+void Scene::orbitCamera(double theta, double phi)
+{
+	camTheta += theta;
+	camPhi += phi;
+	if (camPhi > PHI_UPPER_BOUND)
+		camPhi = PHI_UPPER_BOUND;
+	if (camPhi < PHI_LOWER_BOUND)
+		camPhi = PHI_LOWER_BOUND;
+}
+
+void Scene::toggleLight(int light)
+{
+	if (light == 0 || light == 1)
+		lightEnabled[light] = !lightEnabled[light];
+}
+
+const char *Scene::getTextureSource() const
+{
+	if (!textureCacheReady)
+		return "unavailable";
+	return textureCacheBuilt ? "decoded into the cache" : "mapped from the cache";
+}
+
+void Scene::prepareTextures()
+{
+	const std::vector<const char *> &files = catalog.getTextureFiles();
+	textureCacheReady = textureCache.open(textureCachePath.c_str(), files, TEXTURE_LAYER_WIDTH, TEXTURE_LAYER_HEIGHT);
+	textureCacheBuilt = false;
+	if (!textureCacheReady && !files.empty())
+	{
+		textureCacheReady = textureCache.build(textureCachePath.c_str(), files, TEXTURE_LAYER_WIDTH, TEXTURE_LAYER_HEIGHT, pool);
+		textureCacheBuilt = textureCacheReady;
+		if (!textureCacheReady)
+			fprintf(stderr, "%s\n", textureCache.getError().c_str());
+	}
+}
+
+void Scene::loadTextures()
+{
+	pool.wait(); // prepareTextures()
+	const std::vector<const char *> &files = catalog.getTextureFiles();
+	texLayer.assign(files.size(), -1.0f);
+	texID.assign(files.size(), 0);
+	texturesStreamed = textureCacheReady && sphereRenderer.isReady();
+	if (texturesStreamed)
+	{
+		// slots for as many full mip chains as the budget holds
+		long long layerBytes = 0;
+		for (int level = 0; level != textureCache.getLevels(); ++level)
+			layerBytes += 3LL * textureCache.getWidth(level) * textureCache.getHeight(level);
+		long long slots = (long long)textureBudgetMB * 1024 * 1024 / layerBytes;
+		if (slots > textureCache.getLayers())
+			slots = textureCache.getLayers();
+		if (slots < 1)
+			slots = 1;
+		sphereRenderer.setTextureLayers(TEXTURE_LAYER_WIDTH, TEXTURE_LAYER_HEIGHT, (int)slots, textureCache.getLevels());
+		textureResidency.reset(textureCache.getLayers(), (int)slots);
+		// the placeholders are one small level of every texture, straight from the mapped cache
+		int level = 0;
+		while (level + 1 < textureCache.getLevels() && textureCache.getWidth(level) > TEXTURE_PLACEHOLDER_WIDTH)
+			++level;
+		sphereRenderer.setPlaceholders(textureCache.getWidth(level), textureCache.getHeight(level),
+			textureCache.getLayers(), textureCache.getLevel(level));
+		for (size_t i = 0; i != files.size(); ++i)
+			if (textureCache.hasLayer((int)i))
+				texLayer[i] = (float)i;
+	}
+	else if (textureCacheReady)
+	{
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (size_t i = 0; i != files.size(); ++i)
+		{
+			if (!textureCache.hasLayer((int)i))
+				continue;
+			glGenTextures(1, &texID[i]);
+			glBindTexture(GL_TEXTURE_2D, texID[i]);
+			for (int level = 0; level != textureCache.getLevels(); ++level)
+				glTexImage2D(GL_TEXTURE_2D, level, 3, textureCache.getWidth(level), textureCache.getHeight(level),
+					0, GL_RGB, GL_UNSIGNED_BYTE, textureCache.getLayer(level, (int)i));
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		}
+	}
+}
+
+void Scene::streamTextures()
+{
+	if (!texturesStreamed)
+		return;
+	textureResidency.schedule(TEXTURE_UPLOADS_PER_FRAME, textureLoads);
+	for (size_t n = 0; n != textureLoads.size(); ++n)
+	{
+		const TextureResidency::Load &load = textureLoads[n];
+		for (int level = 0; level != textureCache.getLevels(); ++level)
+		{
+			sphereRenderer.setTextureLayer(load.slot, textureCache.getLayer(level, load.texture), level);
+			textureResidency.addUploadedBytes(3LL * textureCache.getWidth(level) * textureCache.getHeight(level));
+		}
+	}
+	if (!textureLoads.empty())
+		renderState.invalidateTextures(); // the uploads bind the array on the active unit
+}
+
+void Scene::setupProjection(int width, int height)
+{
+	// the projection matrix is only replaced when the window size changes
+	renderState.setPerspective(FIELD_OF_VIEW, (double)width / (double)height, 0.1, 1000000.0);
+}
+
+void Scene::setupViewing()
+{
+	AstronomicalObject ao(renderStore, viewObject);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	double distance = 2 * ao.getRadius() + camDistance;
+	camX = ao.getX() + distance * sin(camPhi) * sin(camTheta + ao.getRadianRevolution());
+	camY = ao.getY() + distance * cos(camPhi);
+	camZ = ao.getZ() + distance * sin(camPhi) * cos(camTheta + ao.getRadianRevolution());
+
+	gluLookAt(
+		camX, camY, camZ,
+		ao.getX(), ao.getY(), ao.getZ(),
+		0, 1, 0);
+	glGetDoublev(GL_MODELVIEW_MATRIX, viewMatrix);
+}
+
+int Scene::pick(int x, int y) const
+{
+	// through the centre of the pixel, in eye space, then rotated into the
+	// world by the transposed rotation of the view matrix
+	double tangent = tan(FIELD_OF_VIEW * PI / 360.0);
+	double eye[3] = {
+		(2.0 * (x + 0.5) / viewport[0] - 1.0) * tangent * viewport[0] / viewport[1],
+		(1.0 - 2.0 * (y + 0.5) / viewport[1]) * tangent,
+		-1.0 };
+	double direction[3];
+	for (int a = 0; a != 3; ++a)
+		direction[a] = viewMatrix[a * 4] * eye[0] + viewMatrix[a * 4 + 1] * eye[1] + viewMatrix[a * 4 + 2] * eye[2];
+	double origin[3] = { camX, camY, camZ };
+	// bodies smaller than a few pixels are picked as if they were that large
+	double tolerance = PICK_PIXELS * FIELD_OF_VIEW * PI / 180.0 / viewport[1];
+	return picker.pick(origin, direction, tolerance);
+}
+
+void Scene::setupLighting()
+{
+	GLfloat white[4] = { 1.0, 1.0, 1.0, 1.0 };
+	GLfloat black[4] = { 0.0, 0.0, 0.0, 1.0 };
+	GLfloat position0[4] = { 0.0, 1.0, 0.0, 0.0 };
+	GLfloat position1[4] = { 0.0, -1.0, 0.0, 0.0 };
+	// the positions follow the view. The instanced shader adds both lights
+	// whatever their enable state, so a light that is off is also black.
+	for (int l = 0; l != 2; ++l)
+	{
+		const GLfloat *color = lightEnabled[l] ? white : black;
+		renderState.setLightColors(l, color, color, color);
+		renderState.setLightPosition(l, l == 0 ? position0 : position1, viewMatrix);
+		renderState.enable(GL_LIGHT0 + l, lightEnabled[l]);
+	}
+}
+
+double Scene::projectedPixels(int body)
+{
+	AstronomicalObject ao(renderStore, body);
+	double dx = ao.getX() - camX, dy = ao.getY() - camY, dz = ao.getZ() - camZ;
+	return LevelOfDetail::projectedRadius(ao.getRadius(), sqrt(dx * dx + dy * dy + dz * dz),
+		FIELD_OF_VIEW, viewport[1]);
+}
+
+void Scene::queueBodies()
+{
+	renderQueue.clear();
+	int shader = sphereRenderer.isReady() ? SHADER_INSTANCED : SHADER_FIXED;
+	if (shader == SHADER_INSTANCED)
+		textureResidency.beginFrame();
+	for (size_t k = 0; k != visibleBodies.size(); ++k)
+	{
+		int i = visibleBodies[k];
+		double pixels = projectedPixels(i);
+		int level = levelOfDetail.select(i, pixels);
+		int texture = catalog.getTexture(i);
+		if (texture >= 0 && (shader == SHADER_INSTANCED ? texLayer[texture] < 0 : texID[texture] == 0))
+			texture = -1; // failed to load
+		if (shader == SHADER_INSTANCED && texturesStreamed && texture >= 0)
+			textureResidency.use(texture, pixels);
+		renderQueue.add(shader, MATERIAL_SILVER, texture, level, i);
+	}
+	renderQueue.sort();
+}
+
+void Scene::drawInstanced(int first, int end)
+{
+	sphereInstances.resize(end - first);
+	sphereLevels.resize(end - first);
+	for (int q = first; q != end; ++q)
+	{
+		const RenderQueue::Item &item = renderQueue[q];
+		AstronomicalObject ao(renderStore, item.body);
+		SphereRenderer::Instance &instance = sphereInstances[q - first];
+		SphereRenderer::setModel(instance, ao.getX(), ao.getY(), ao.getZ(),
+			ao.getAngleRevolution(), ao.getAngleAxialTilt(), ao.getAngleRotation(), ao.getRadius());
+		instance.placeholder = item.texture >= 0 ? texLayer[item.texture] : -1;
+		instance.layer = -1;
+		if (texturesStreamed && item.texture >= 0)
+			instance.layer = (float)textureResidency.use(item.texture, 0);
+		sphereLevels[q - first] = item.level;
+	}
+	sphereRenderer.draw(renderState, &sphereInstances[0], &sphereLevels[0], end - first);
+}
+
+void Scene::drawFixed(int first, int end)
+{
+	renderState.useProgram(0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	int arrays = -1; // mesh level the pointers are set for
+	for (int q = first; q != end; ++q)
+	{
+		const RenderQueue::Item &item = renderQueue[q];
+		renderState.bindTexture(0, GL_TEXTURE_2D, item.texture >= 0 ? texID[item.texture] : 0);
+		int level = item.level < SPHERE_MESHES ? item.level : SPHERE_MESHES - 1;
+		const SphereMesh &sphereMesh = sphereMeshes[level];
+		if (level != arrays)
+		{
+			const SphereMesh::Vertex *v = &sphereMesh.getVertices()[0];
+			glVertexPointer(3, GL_FLOAT, sizeof(SphereMesh::Vertex), v->position);
+			glNormalPointer(GL_FLOAT, sizeof(SphereMesh::Vertex), v->normal);
+			glTexCoordPointer(2, GL_FLOAT, sizeof(SphereMesh::Vertex), v->texCoord);
+			arrays = level;
+		}
+
+		AstronomicalObject ao(renderStore, item.body);
+		GLfloat radius = ao.getRadius();
+		glPushMatrix();
+		glTranslatef(ao.getX(), ao.getY(), ao.getZ()); // Revolution
+		glRotatef(ao.getAngleRevolution(), 0, 1, 0); // Revolution
+		glRotatef(ao.getAngleAxialTilt(), 0, 0, 1); // axial tilt
+		glRotatef(ao.getAngleRotation(), 0, 1, 0); // Rotation
+		glScalef(radius, radius, radius); // unit mesh; GL_NORMALIZE fixes the normals
+		for (int s = 0; s != sphereMesh.getSlices(); ++s)
+			glDrawArrays(GL_TRIANGLE_STRIP, sphereMesh.getStripFirst(s), sphereMesh.getStripLength());
+		renderState.addDrawCalls(sphereMesh.getSlices());
+		glPopMatrix();
+	}
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void Scene::drawBodies()
+{
+	Profiler::Scope scope(profiler, "drawScene");
+	Profiler::GpuScope gpuScope(profiler, "drawScene");
+	glMatrixMode(GL_MODELVIEW);
+
+	GLdouble projection[16];
+	glGetDoublev(GL_PROJECTION_MATRIX, projection);
+	{
+		Profiler::Scope cullScope(profiler, "cull");
+		culler.setView(projection, viewMatrix, camX, camY, camZ);
+		culler.cull(renderStore, visibleBodies);
+	}
+	labels.begin(projection, viewMatrix, viewport[0], viewport[1]);
+	for (size_t k = 0; k != visibleBodies.size(); ++k)
+	{
+		AstronomicalObject ao(renderStore, visibleBodies[k]);
+		labels.add(visibleBodies[k], ao.getX(), ao.getY(), ao.getZ());
+	}
+
+	queueBodies();
+	streamTextures();
+	{
+		Profiler::Scope sphereScope(profiler, "spheres");
+		for (int first = 0, end; first != renderQueue.size(); first = end)
+		{
+			end = renderQueue.endOfRun(first);
+			renderState.setMaterial(&MATERIALS[renderQueue[first].material]);
+			if (renderQueue[first].shader == SHADER_INSTANCED)
+				drawInstanced(first, end);
+			else
+				drawFixed(first, end);
+		}
+	}
+
+	if (trailsShown)
+	{
+		Profiler::Scope trailScope(profiler, "trails");
+		trails.draw(renderState);
+	}
+
+	Profiler::Scope labelScope(profiler, "labels");
+	Profiler::GpuScope labelGpuScope(profiler, "labels");
+	// fixed function, on unit 0; its own state is pushed and popped
+	renderState.useProgram(0);
+	renderState.activeTexture(0);
+	labels.draw();
+	renderState.addDrawCalls(1);
+}
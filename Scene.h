@@ -0,0 +1,188 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "GLHeaders.h"
+#include "BodyCatalog.h"
+#include "BodyPicker.h"
+#include "BodyStore.h"
+#include "Checkpoint.h"
+#include "FrustumCuller.h"
+#include "LabelRenderer.h"
+#include "LevelOfDetail.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include "Simulation.h"
+#include "SphereMesh.h"
+#include "SphereRenderer.h"
+#include "TextureCache.h"
+#include "TextureResidency.h"
+#include "ThreadPool.h"
+#include "TrailRenderer.h"
+
+// The Solar System without a window: the bodies of a catalog, their
+// simulation, the camera and everything that draws them. A platform layer
+// (the GLUT viewer, the headless renderer) owns the context and the
+// window, forwards input and calls update() and render() once per frame.
+class Scene
+{
+public:
+	static const double FIELD_OF_VIEW; // degree, vertical
+
+	explicit Scene(ThreadPool &pool);
+
+	// loads the catalog and starts preparing the textures on the pool
+	bool load(const char *catalogPath);
+	const std::string &getError() const { return error; }
+	// size of the texture slot pool; before initializeGraphics()
+	void setTextureBudget(int megabytes) { textureBudgetMB = megabytes; }
+	// needs a current context
+	void initializeGraphics();
+
+	// advances the simulation by real seconds on the calling thread; not
+	// while the simulation runs on its own thread (getSimulation().start())
+	void update(double seconds);
+	// draws the newest snapshot of the simulation
+	void render(int width, int height);
+
+	// camera, orbiting the viewed body
+	int getViewObject() const { return viewObject; }
+	void setViewObject(int body);
+	void orbitCamera(double theta, double phi);
+	void zoomCamera(double distance) { camDistance += distance; }
+	void toggleLight(int light);
+	// the body under a window pixel (origin top left) in the last frame, -1 if none
+	int pick(int x, int y) const;
+
+	// the camera and the whole simulation; restoring needs the same catalog
+	// and sets the error if it fails, leaving everything as it was
+	void saveCheckpoint(Checkpoint &checkpoint);
+	bool restoreCheckpoint(Checkpoint &checkpoint);
+
+	// warp, pause, epoch and distance mode; safe while it runs on its thread
+	Simulation &getSimulation() { return simulation; }
+	// with its own thread the simulation publishes at its own pace; the
+	// bodies are then drawn between the last two snapshots at the frame's time
+	void setInterpolation(bool on) { interpolation = on; }
+	// whether the next frame may differ from the last one without any input:
+	// the simulation moves or has requests to apply, a snapshot is being
+	// interpolated, textures are still streaming in
+	bool isAnimating() const;
+
+	const BodyCatalog &getCatalog() const { return catalog; }
+	const BodyStore &getStore() const { return renderStore; }
+	const FrustumCuller::Stats &getCullingStats() const { return culler.getStats(); }
+	const TextureResidency::Stats &getResidencyStats() const { return textureResidency.getStats(); }
+	// GL state changes of the last frame
+	const RenderState::Stats &getRenderStats() const { return renderState.getStats(); }
+	int getStateChanges() const { return renderState.getChanges(); }
+	// the phases of update() and render(); the platform layer adds its own
+	Profiler &getProfiler() { return profiler; }
+	// the average phase times of the last second over the scene; enables the profiler
+	void setProfileOverlay(bool shown);
+	bool isProfileOverlayShown() const { return profileOverlay; }
+	// the recent path of every body, one sample per interval of simulated
+	// hours; the length in samples is set before initializeGraphics()
+	void setTrails(bool shown);
+	bool areTrailsShown() const { return trailsShown; }
+	void setTrail(int body, bool shown);
+	void setTrailLength(int samples) { trailLength = samples; }
+	void setTrailInterval(double hours) { trailInterval = hours; }
+	// how the textures were obtained, for the startup report
+	const char *getTextureSource() const;
+private:
+	Scene(const Scene &);
+	Scene &operator=(const Scene &);
+
+	void prepareTextures();
+	void loadTextures();
+	void streamTextures();
+	void setupProjection(int width, int height);
+	void setupViewing();
+	void setupLighting();
+	double projectedPixels(int body);
+	void queueBodies();
+	void drawInstanced(int first, int end);
+	void drawFixed(int first, int end);
+	void drawBodies();
+	void drawProfileOverlay();
+	void applySnapshot();
+	void sampleTrails();
+
+	ThreadPool &pool;
+	std::string error;
+
+	// Objects in the Solar System, loaded from the catalog into the
+	// simulation. The renderer draws its own copy of the store, with the
+	// positions and angles of the newest snapshot.
+	Simulation simulation;
+	BodyCatalog catalog;
+	std::string catalogPath;
+	BodyStore renderStore;
+	BodySnapshot previousSnapshot;
+	bool interpolation = true;
+	bool interpolating = false; // the last frame was between two snapshots
+	std::vector<double> shownX, shownY, shownZ;
+
+	// camera
+	double camX = 0, camY = 0, camZ = 0;
+	double camDistance = 1.0;
+	double camTheta = 0.0;
+	double camPhi;
+	int viewObject = 0;
+	int viewport[2];
+	GLdouble viewMatrix[16];
+	bool lightEnabled[2];
+
+	// Bodies are drawn through a queue sorted by shader, material, texture
+	// and mesh, and every state change goes through a cache that drops the
+	// ones that would not change anything.
+	RenderState renderState;
+	RenderQueue renderQueue;
+
+	// Textures are decoded once into a mipmapped cache file next to the
+	// catalog, on the thread pool while the window opens; later runs only
+	// map the file. With OpenGL 3.3 only the textures on screen are kept in
+	// the array, in a fixed number of slots sized from a memory budget. A
+	// texture is uploaded when its body becomes visible, largest on screen
+	// first, and a low resolution placeholder level is shown until it arrives.
+	TextureCache textureCache;
+	std::string textureCachePath;
+	bool textureCacheReady = false;
+	bool textureCacheBuilt = false;
+	int textureBudgetMB;
+	TextureResidency textureResidency;
+	std::vector<TextureResidency::Load> textureLoads;
+	bool texturesStreamed = false;
+	std::vector<float> texLayer; // per texture file, -1 if it failed to load
+	std::vector<GLuint> texID; // 2D textures of the fixed-function fallback
+
+	// Levels of detail, chosen per body from its radius on screen in pixels.
+	// The last level is an impostor quad, drawn with the coarsest mesh without shaders.
+	std::vector<SphereMesh> sphereMeshes;
+	LevelOfDetail levelOfDetail;
+	SphereRenderer sphereRenderer; // one call per level; drawFixed() is the fallback
+	std::vector<SphereRenderer::Instance> sphereInstances;
+	std::vector<int> sphereLevels;
+	// only bodies that can be on screen are drawn
+	FrustumCuller culler;
+	std::vector<int> visibleBodies;
+	// bounding volumes of the bodies as drawn, refit every frame for picking
+	BodyPicker picker;
+	// body names, drawn in one batch from the glyph atlas in texture_font.bmp
+	LabelRenderer labels;
+	// Trails are sampled from the snapshots, at most one sample per
+	// snapshot, into a ring on the GPU; each sample uploads only itself.
+	TrailRenderer trails;
+	bool trailsShown = false;
+	int trailLength;
+	double trailInterval;
+	double trailTime = 0; // simulated hours of the newest sample
+	long long trailSequence = -1; // snapshot of the newest sample
+
+	Profiler profiler;
+	bool profileOverlay = false;
+	LabelRenderer overlay; // one label per line
+	int overlayLines = 0;
+	long long overlayUpdated = 0; // profiler time
+};
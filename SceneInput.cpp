@@ -0,0 +1,255 @@
+#include <stdint.h>
+#include <string.h>
+#include "SceneInput.h"
+
+namespace
+{
+	const double PI = 3.141593;
+	const double HOURS_PER_YEAR = 365.25 * 24;
+	const double DRAG_DEGREES_PER_PIXEL = 0.5;
+	const char MAGIC[4] = { 'S', 'R', 'E', 'C' };
+}
+
+bool SceneInput::dispatch(int type, int code)
+{
+	Simulation &simulation = scene.getSimulation();
+	switch (type)
+	{
+	case KEYBOARD:
+		switch (code)
+		{
+		case 'D':
+			scene.zoomCamera(1);
+			return true;
+		case 'd':
+			scene.zoomCamera(-1);
+			return true;
+		case 9: // 'tab' | GL_LIGHT0
+			scene.toggleLight(0);
+			return true;
+		case '1': // GL_LIGHT1
+			scene.toggleLight(1);
+			return true;
+		case ' ': // pause
+			simulation.togglePause();
+			return true;
+		case '+': // time warp
+			simulation.scaleWarp(2);
+			return true;
+		case '-':
+			simulation.scaleWarp(0.5);
+			return true;
+		case 't': // orbit trails
+			scene.setTrails(!scene.areTrailsShown());
+			return true;
+		}
+		return false;
+	case SPECIAL:
+		switch (code)
+		{
+		case KEY_RIGHT:
+			scene.orbitCamera(PI / 180.0, 0);
+			return true;
+		case KEY_LEFT:
+			scene.orbitCamera(-PI / 180.0, 0);
+			return true;
+		case KEY_DOWN:
+			scene.orbitCamera(0, PI / 180.0);
+			return true;
+		case KEY_UP:
+			scene.orbitCamera(0, -PI / 180.0);
+			return true;
+		}
+		return false;
+	case MENU_VIEW:
+		scene.setViewObject(code);
+		return true;
+	case MENU_SPEED:
+		switch (code)
+		{
+		case 0:
+			simulation.togglePause();
+			return true;
+		case 1:
+			simulation.setWarp(0.1);
+			return true;
+		case 2:
+			simulation.setWarp(1);
+			return true;
+		case 3:
+			simulation.setWarp(10);
+			return true;
+		case 4:
+			simulation.setWarp(100);
+			return true;
+		case 5:
+			simulation.setWarp(1000);
+			return true;
+		case 6:
+			simulation.advanceEpoch(100 * HOURS_PER_YEAR);
+			return true;
+		case 7:
+			simulation.setEpoch(0);
+			return true;
+		}
+		return false;
+	case MENU_DISTANCE:
+		switch (code)
+		{
+		case 0: // Real Distance Mode
+			simulation.setDistanceMode(Simulation::REAL_DISTANCE);
+			return true;
+		case 1: // Close Distance Mode
+			simulation.setDistanceMode(Simulation::CLOSE_DISTANCE);
+			return true;
+		case 2: // Gravity Mode, starts from the real distances
+			simulation.setDistanceMode(Simulation::GRAVITY);
+			return true;
+		}
+		return false;
+	case DRAG:
+		if (code == 0)
+			return false;
+		scene.orbitCamera(dragX(code) * DRAG_DEGREES_PER_PIXEL * PI / 180.0, dragY(code) * DRAG_DEGREES_PER_PIXEL * PI / 180.0);
+		return true;
+	}
+	return false;
+}
+
+bool SceneInput::apply(int type, int code)
+{
+	if (!recording)
+		return dispatch(type, code);
+	Simulation &simulation = scene.getSimulation();
+	simulation.beginBatch();
+	bool used = dispatch(type, code);
+	if (used)
+	{
+		Event event = { 0, type, code };
+		simulation.post([this, event]() mutable
+		{
+			event.tick = scene.getSimulation().getTicks();
+			events.push_back(event);
+		});
+	}
+	simulation.endBatch();
+	return used;
+}
+
+void SceneInput::startRecording()
+{
+	events.clear();
+	scene.saveCheckpoint(start);
+	recording = true;
+}
+
+bool SceneInput::stopRecording(const char *path)
+{
+	recording = false;
+	Simulation &simulation = scene.getSimulation();
+	// after the time stamps posted so far
+	simulation.postAndWait([this, &simulation]() { endTick = simulation.getTicks(); });
+
+	// a Checkpoint without its header is a plain byte stream
+	Checkpoint log;
+	const std::vector<unsigned char> &checkpoint = start.getData();
+	for (int k = 0; k != 4; ++k)
+		log.write<char>(MAGIC[k]);
+	log.write<uint32_t>(VERSION);
+	log.write<uint32_t>((uint32_t)checkpoint.size());
+	log.writeArray(checkpoint);
+	log.write<uint32_t>((uint32_t)events.size());
+	for (size_t e = 0; e != events.size(); ++e)
+	{
+		log.write<int64_t>(events[e].tick);
+		log.write<int32_t>(events[e].type);
+		log.write<int32_t>(events[e].code);
+	}
+	log.write<int64_t>(endTick);
+	if (!log.save(path))
+	{
+		error = log.getError();
+		return false;
+	}
+	return true;
+}
+
+bool SceneInput::loadReplay(const char *path)
+{
+	Checkpoint log;
+	if (!log.load(path))
+	{
+		error = log.getError();
+		return false;
+	}
+	char magic[4] = {};
+	uint32_t version = 0, size = 0, count = 0;
+	std::vector<unsigned char> checkpoint;
+	for (int k = 0; k != 4; ++k)
+		log.read(magic[k]);
+	log.read(version);
+	if (memcmp(magic, MAGIC, 4) != 0 || version != VERSION)
+	{
+		error = std::string(path) + ": not a recording of this version";
+		return false;
+	}
+	log.read(size);
+	log.readArray(checkpoint, size);
+	log.read(count);
+	std::vector<Event> loaded;
+	for (uint32_t e = 0; e != count && !log.isFailed(); ++e)
+	{
+		int64_t tick = 0;
+		int32_t type = 0, code = 0;
+		log.read(tick);
+		log.read(type);
+		log.read(code);
+		Event event = { tick, type, code };
+		loaded.push_back(event);
+	}
+	int64_t end = 0;
+	log.read(end);
+	if (log.isFailed())
+	{
+		error = std::string(path) + ": truncated recording";
+		return false;
+	}
+	start.setData(checkpoint.data(), checkpoint.size());
+	if (!scene.restoreCheckpoint(start))
+	{
+		error = std::string(path) + ": " + scene.getError();
+		return false;
+	}
+	events.swap(loaded);
+	nextEvent = 0;
+	endTick = end;
+	Simulation &simulation = scene.getSimulation();
+	simulation.postAndWait([this, &simulation]() { startTick = simulation.getTicks(); });
+	return true;
+}
+
+bool SceneInput::replay(long long steps)
+{
+	// events on the simulation's thread would be applied later than recorded
+	Simulation &simulation = scene.getSimulation();
+	if (simulation.isRunning())
+		return false;
+	for (;;)
+	{
+		long long tick = simulation.getTicks();
+		while (nextEvent != events.size() && events[nextEvent].tick <= tick)
+		{
+			dispatch(events[nextEvent].type, events[nextEvent].code);
+			++nextEvent;
+		}
+		long long due = nextEvent != events.size() ? events[nextEvent].tick : endTick;
+		long long n = due - tick < steps ? due - tick : steps;
+		if (n <= 0)
+			break;
+		simulation.advanceTicks(n);
+		if (simulation.getTicks() == tick)
+			break; // paused: nothing more falls due
+		steps -= simulation.getTicks() - tick;
+	}
+	return nextEvent != events.size() || simulation.getTicks() < endTick;
+}
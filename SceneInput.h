@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Checkpoint.h"
+#include "Scene.h"
+
+// The input of the viewer as it acts on a Scene: keys, special keys and
+// menu items and the mouse, shared by the GLUT viewer and headless replays. A recording
+// starts from a checkpoint of the scene and logs every event with the
+// simulation step it took effect at: the commands of one event and its
+// time stamp are posted in one batch, so they are applied between the
+// same two steps. Replaying the log from the checkpoint with exactly those
+// step counts (Simulation::advanceTicks) reproduces the session bit for bit.
+//
+// Log layout (native little-endian):
+//   header      "SREC", uint32 version, uint32 checkpoint bytes, checkpoint
+//   events      uint32 count, then int64 tick, int32 type, int32 code per event
+//   end         int64 tick the recording stopped at
+class SceneInput
+{
+public:
+	// a body picked with the mouse is a MENU_VIEW of it; a DRAG orbits the camera
+	enum Type { KEYBOARD, SPECIAL, MENU_VIEW, MENU_SPEED, MENU_DISTANCE, DRAG };
+	// the codes of GLUT_KEY_LEFT, ...
+	enum SpecialKey { KEY_LEFT = 100, KEY_UP, KEY_RIGHT, KEY_DOWN };
+	static const unsigned VERSION = 1;
+
+	// the code of a DRAG: the mouse movement in pixels, 16 bits each
+	static int drag(int dx, int dy) { return (dx & 0xffff) | (int)((unsigned)(dy & 0xffff) << 16); }
+	static int dragX(int code) { return (int16_t)(code & 0xffff); }
+	static int dragY(int code) { return (int16_t)((unsigned)code >> 16); }
+
+	explicit SceneInput(Scene &scene) : scene(scene) {}
+
+	// false for input the scene has no use for, which is not recorded either
+	bool apply(int type, int code);
+
+	void startRecording();
+	bool isRecording() const { return recording; }
+	bool stopRecording(const char *path);
+
+	// restores the checkpoint of a recording into the scene
+	bool loadReplay(const char *path);
+	// advances the simulation by up to that many steps, applying the events
+	// that fall on them; false once the recording has ended
+	bool replay(long long steps);
+	long long getReplayStart() const { return startTick; }
+	long long getReplayEnd() const { return endTick; }
+	int getEventCount() const { return (int)events.size(); }
+
+	const std::string &getError() const { return error; }
+private:
+	SceneInput(const SceneInput &);
+	SceneInput &operator=(const SceneInput &);
+
+	struct Event
+	{
+		long long tick;
+		int type;
+		int code;
+	};
+
+	bool dispatch(int type, int code);
+
+	Scene &scene;
+	bool recording = false;
+	Checkpoint start;
+	// appended by the commands that time stamp them, on the simulation's thread
+	std::vector<Event> events;
+	long long startTick = 0;
+	long long endTick = 0;
+	size_t nextEvent = 0; // replay
+	std::string error;
+};
@@ -0,0 +1,354 @@
+#include <chrono>
+#include <future>
+#include <stdint.h>
+#include "Simulation.h"
+
+namespace
+{
+	const int MAX_GRAVITY_STEPS = 32;
+	const int THREAD_INTERVAL_MS = 1; // as often as the old GLUT timer
+}
+
+Simulation::Simulation(ThreadPool &pool)
+	: clock(store.getHoursPerTick(), store.getHoursPerTick() * 1000.0),
+	nbody(pool),
+	stopping(false),
+	paused(false),
+	pendingCommands(0)
+{
+}
+
+double Simulation::realSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Simulation::reset()
+{
+	jumped = true;
+	publish();
+}
+
+void Simulation::update(double seconds)
+{
+	int applied = runCommands();
+	step(seconds);
+	pendingCommands -= applied;
+}
+
+void Simulation::advanceTicks(long long steps)
+{
+	int applied = runCommands();
+	if (clock.isPaused())
+		steps = 0;
+	clock.advance(steps);
+	advance(steps);
+	pendingCommands -= applied;
+}
+
+void Simulation::step(double seconds)
+{
+	advance(clock.update(seconds));
+}
+
+void Simulation::advance(long long steps)
+{
+	if (steps > 0)
+	{
+		ticks += steps;
+		store.setEpoch(clock.getTime());
+		if (gravityMode)
+		{
+			for (long long i = 0; i != steps; ++i)
+				nbody.step(clock.getStep());
+			nbody.writePositions(store);
+		}
+		changed = true;
+	}
+	if (changed)
+		publish();
+	paused = clock.isPaused();
+}
+
+void Simulation::publish()
+{
+	store.updateWorld();
+	BodySnapshot &snapshot = snapshots.getBack();
+	snapshot.sequence = published++;
+	snapshot.tick = ticks;
+	snapshot.time = clock.getTime();
+	snapshot.realTime = realSeconds();
+	if (jumped || snapshot.sequence == 0)
+		lastJump = snapshot.sequence;
+	snapshot.lastJump = lastJump;
+	// the capacity stays, so after the first round nothing is allocated
+	snapshot.x.assign(store.worldX.begin(), store.worldX.end());
+	snapshot.y.assign(store.worldY.begin(), store.worldY.end());
+	snapshot.z.assign(store.worldZ.begin(), store.worldZ.end());
+	snapshot.angleRevolution.assign(store.angleRevolution.begin(), store.angleRevolution.end());
+	snapshot.angleRotation.assign(store.angleRotation.begin(), store.angleRotation.end());
+	snapshots.publish();
+	changed = jumped = false;
+}
+
+void Simulation::start()
+{
+	if (isRunning())
+		return;
+	stopping = false;
+	thread = std::thread(&Simulation::loop, this);
+}
+
+void Simulation::stop()
+{
+	if (!isRunning())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		stopping = true;
+		commandPosted.notify_one();
+	}
+	thread.join();
+	pendingCommands -= runCommands(); // posted while it stopped
+}
+
+void Simulation::loop()
+{
+	std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+	while (!stopping)
+	{
+		if (clock.isPaused())
+		{
+			// nothing moves until a request arrives
+			std::unique_lock<std::mutex> lock(commandMutex);
+			commandPosted.wait(lock, [this]() { return stopping || !commands.empty(); });
+			// the wait is not simulated time, even if the request resumes
+			last = std::chrono::steady_clock::now();
+		}
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(THREAD_INTERVAL_MS));
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - last).count();
+		last = now;
+		int applied = runCommands();
+		step(elapsed);
+		pendingCommands -= applied;
+	}
+}
+
+void Simulation::post(std::function<void()> command)
+{
+	if (!isRunning())
+	{
+		command();
+		paused = clock.isPaused();
+		return;
+	}
+	if (batching)
+	{
+		batch.push_back(command);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(commandMutex);
+	commands.push_back(command);
+	++pendingCommands;
+	commandPosted.notify_one();
+}
+
+void Simulation::endBatch()
+{
+	batching = false;
+	if (batch.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		commands.insert(commands.end(), batch.begin(), batch.end());
+		pendingCommands += (int)batch.size();
+		commandPosted.notify_one();
+	}
+	batch.clear();
+}
+
+void Simulation::postAndWait(const std::function<void()> &command)
+{
+	if (!isRunning())
+	{
+		command();
+		paused = clock.isPaused();
+		return;
+	}
+	std::promise<void> done;
+	std::future<void> finished = done.get_future();
+	post([&]() { command(); done.set_value(); });
+	finished.wait();
+}
+
+int Simulation::runCommands()
+{
+	{
+		std::lock_guard<std::mutex> lock(commandMutex);
+		if (commands.empty())
+			return 0;
+		running.swap(commands);
+	}
+	int applied = (int)running.size();
+	for (size_t c = 0; c != running.size(); ++c)
+		running[c]();
+	running.clear();
+	return applied;
+}
+
+void Simulation::setWarp(double warp)
+{
+	post([this, warp]() { clock.setWarp(warp); });
+}
+
+void Simulation::scaleWarp(double factor)
+{
+	post([this, factor]() { clock.setWarp(clock.getWarp() * factor); });
+}
+
+void Simulation::togglePause()
+{
+	post([this]() { clock.togglePause(); });
+}
+
+void Simulation::setEpoch(double hours)
+{
+	post([this, hours]() { applyEpoch(hours); });
+}
+
+void Simulation::advanceEpoch(double hours)
+{
+	post([this, hours]() { applyEpoch(clock.getTime() + hours); });
+}
+
+void Simulation::applyEpoch(double hours)
+{
+	clock.setTime(hours);
+	store.setEpoch(hours);
+	if (gravityMode)
+	{
+		// no closed form for N-body, restart from the kinematic state
+		nbody.initialize(store);
+		nbody.writePositions(store);
+	}
+	changed = jumped = true;
+}
+
+void Simulation::setDistanceMode(DistanceMode mode)
+{
+	post([this, mode]()
+	{
+		switch (mode)
+		{
+		case REAL_DISTANCE:
+			setGravityMode(false);
+			store.setRealDistanceMode(true);
+			break;
+		case CLOSE_DISTANCE:
+			setGravityMode(false);
+			store.setRealDistanceMode(false);
+			break;
+		case GRAVITY: // starts from the real distances
+			store.setRealDistanceMode(true);
+			setGravityMode(true);
+			break;
+		}
+		changed = jumped = true;
+	});
+}
+
+void Simulation::setGravityMode(bool enabled)
+{
+	if (enabled && !gravityMode)
+	{
+		store.setEpoch(clock.getTime());
+		nbody.initialize(store);
+		nbody.writePositions(store);
+	}
+	gravityMode = enabled;
+	clock.setMaxSteps(enabled ? MAX_GRAVITY_STEPS : 0);
+	if (!enabled)
+		store.setEpoch(clock.getTime());
+}
+
+void Simulation::save(Checkpoint &checkpoint)
+{
+	postAndWait([&]() { writeState(checkpoint); });
+}
+
+bool Simulation::restore(Checkpoint &checkpoint)
+{
+	bool restored = false;
+	postAndWait([&]()
+	{
+		restored = readState(checkpoint);
+		if (restored)
+			publish();
+	});
+	return restored;
+}
+
+void Simulation::writeState(Checkpoint &checkpoint) const
+{
+	checkpoint.write<int64_t>(ticks);
+	checkpoint.write<double>(clock.getStartTime());
+	checkpoint.write<int64_t>(clock.getTicks());
+	checkpoint.write<double>(clock.getWarp());
+	checkpoint.write<uint8_t>(clock.isPaused());
+	checkpoint.write<uint8_t>(gravityMode);
+	checkpoint.write<double>(store.getEpoch());
+	checkpoint.writeArray(store.realDistanceMode);
+	if (gravityMode)
+	{
+		const std::vector<double> *state[] = { &nbody.x, &nbody.y, &nbody.z, &nbody.vx, &nbody.vy, &nbody.vz, &nbody.ax, &nbody.ay, &nbody.az };
+		for (int k = 0; k != 9; ++k)
+			checkpoint.writeArray(*state[k]);
+	}
+}
+
+bool Simulation::readState(Checkpoint &checkpoint)
+{
+	// everything is read before anything changes
+	int64_t savedTicks = 0, clockTicks = 0;
+	double start = 0, warp = 1, epoch = 0;
+	uint8_t savedPaused = 0, gravity = 0;
+	std::vector<char> realDistance;
+	std::vector<double> state[9];
+	int n = store.size();
+	checkpoint.read(savedTicks);
+	checkpoint.read(start);
+	checkpoint.read(clockTicks);
+	checkpoint.read(warp);
+	checkpoint.read(savedPaused);
+	checkpoint.read(gravity);
+	checkpoint.read(epoch);
+	checkpoint.readArray(realDistance, n);
+	if (gravity)
+		for (int k = 0; k != 9; ++k)
+			checkpoint.readArray(state[k], n);
+	if (checkpoint.isFailed())
+		return false;
+
+	ticks = savedTicks;
+	clock.setTime(start, clockTicks);
+	clock.setWarp(warp);
+	clock.setPaused(savedPaused != 0);
+	for (int i = 0; i != n; ++i)
+		if ((store.realDistanceMode[i] != 0) != (realDistance[i] != 0))
+			store.setRealDistanceMode(i, realDistance[i] != 0); // recomputes the orbit
+	store.setEpoch(epoch);
+	gravityMode = gravity != 0;
+	clock.setMaxSteps(gravityMode ? MAX_GRAVITY_STEPS : 0);
+	if (gravityMode)
+	{
+		std::vector<double> *target[] = { &nbody.x, &nbody.y, &nbody.z, &nbody.vx, &nbody.vy, &nbody.vz, &nbody.ax, &nbody.ay, &nbody.az };
+		for (int k = 0; k != 9; ++k)
+			target[k]->swap(state[k]);
+		nbody.mass = store.mass;
+		nbody.writePositions(store);
+	}
+	changed = jumped = true;
+	return true;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BodyStore.h"
+#include "Checkpoint.h"
+#include "NBodySimulation.h"
+#include "SimulationClock.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+
+// What the renderer needs of the bodies at one simulated instant. Written
+// by the simulation, read by the renderer; never changed once published.
+struct BodySnapshot
+{
+	long long sequence = 0; // snapshots published before this one
+	long long tick = 0; // steps simulated before this one
+	double time = 0; // simulated hours
+	double realTime = 0; // steady clock seconds when it was published
+	long long lastJump = 0; // sequence of the last discontinuous change (epoch, mode): nothing interpolates across it
+	std::vector<double> x, y, z; // world position, scene units
+	std::vector<double> angleRevolution; // degree
+	std::vector<double> angleRotation; // degree
+};
+
+// The bodies of a BodyStore moving in simulated time: the kinematic orbits
+// or, in gravity mode, the N-body integrator, advanced in fixed steps by a
+// SimulationClock. Each change is published as a BodySnapshot through a
+// triple buffer, so a renderer on another thread takes the newest one
+// without locks. update() runs the simulation on the calling thread;
+// start() gives it a thread of its own that follows real time. Requests
+// (warp, pause, epoch, distance mode) go through post() and are applied
+// between two steps on whichever thread runs the simulation. While paused
+// the thread sleeps until the next request.
+class Simulation
+{
+public:
+	enum DistanceMode { REAL_DISTANCE, CLOSE_DISTANCE, GRAVITY };
+
+	explicit Simulation(ThreadPool &pool);
+	~Simulation() { stop(); }
+
+	// the bodies; only while the simulation is not running on its thread
+	BodyStore &getStore() { return store; }
+	// publishes the state of the store as it is, e.g. once it is loaded
+	void reset();
+
+	// real seconds on the calling thread; not while start()ed
+	void update(double seconds);
+	// exactly that many steps whatever the warp, none while paused; not while start()ed
+	void advanceTicks(long long steps);
+	// steps so far; on the thread that runs the simulation, e.g. in a posted
+	// command. The snapshots carry them for other threads.
+	long long getTicks() const { return ticks; }
+	void start();
+	void stop();
+	bool isRunning() const { return thread.joinable(); }
+	// for a renderer deciding whether to draw: nothing moves while paused,
+	// and requests not yet applied will publish a snapshot
+	bool isPaused() const { return paused; }
+	bool hasPendingRequests() const { return pendingCommands != 0; }
+
+	// runs command with the simulation, now or between two steps of its thread
+	void post(std::function<void()> command);
+	// runs command with the simulation like post() and waits until it ran; not in a batch
+	void postAndWait(const std::function<void()> &command);
+	// the commands posted in between are applied together, between the same two steps
+	void beginBatch() { batching = true; }
+	void endBatch();
+	void setWarp(double warp);
+	void scaleWarp(double factor);
+	void togglePause();
+	void setEpoch(double hours);
+	void advanceEpoch(double hours);
+	void setDistanceMode(DistanceMode mode);
+
+	// the simulated state, without the real time left over from the last
+	// step; waits for the simulation's thread if it runs. Not in a batch.
+	void save(Checkpoint &checkpoint);
+	// false, and nothing changed, if the checkpoint is truncated
+	bool restore(Checkpoint &checkpoint);
+
+	// reader side: the snapshot taken last, and whether a newer one waits
+	bool hasNewSnapshot() const { return snapshots.hasNew(); }
+	bool takeSnapshot() { return snapshots.take(); }
+	const BodySnapshot &getSnapshot() const { return snapshots.getFront(); }
+	static double realSeconds();
+private:
+	Simulation(const Simulation &);
+	Simulation &operator=(const Simulation &);
+
+	void step(double seconds);
+	void advance(long long steps);
+	void writeState(Checkpoint &checkpoint) const;
+	bool readState(Checkpoint &checkpoint);
+	void applyEpoch(double hours);
+	void setGravityMode(bool enabled);
+	int runCommands();
+	void publish();
+	void loop();
+
+	BodyStore store;
+	// at warp 1 one tick of the store passes per millisecond. In gravity
+	// mode steps are capped per update to keep up with real time.
+	SimulationClock clock;
+	NBodySimulation nbody;
+	bool gravityMode = false;
+	bool changed = false; // since the last snapshot
+	bool jumped = false; // discontinuously
+	long long ticks = 0;
+
+	TripleBuffer<BodySnapshot> snapshots;
+	long long published = 0;
+	long long lastJump = 0;
+
+	std::thread thread;
+	std::atomic<bool> stopping;
+	std::atomic<bool> paused; // the clock's, for other threads
+	std::atomic<int> pendingCommands; // posted, not yet applied and published
+	std::mutex commandMutex;
+	std::condition_variable commandPosted;
+	std::vector<std::function<void()> > commands;
+	std::vector<std::function<void()> > running; // taken from commands
+	bool batching = false; // posting thread only
+	std::vector<std::function<void()> > batch;
+};
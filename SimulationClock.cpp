@@ -0,0 +1,20 @@
+#include <math.h>
+#include "SimulationClock.h"
+
+SimulationClock::SimulationClock(double stepHours, double hoursPerSecond)
+	: stepHours(stepHours), hoursPerSecond(hoursPerSecond)
+{
+}
+
+int SimulationClock::update(double realSeconds)
+{
+	if (paused || realSeconds <= 0)
+		return 0;
+	accumulator += realSeconds * hoursPerSecond * warp;
+	double steps = floor(accumulator / stepHours);
+	accumulator -= steps * stepHours;
+	if (maxSteps > 0 && steps > maxSteps)
+		steps = maxSteps;
+	ticks += (long long)steps;
+	return (int)steps;
+}
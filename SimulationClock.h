@@ -0,0 +1,46 @@
+#pragma once
+
+// Fixed-timestep simulation clock.
+// Real elapsed time is scaled by hoursPerSecond * warp and collected in an
+// accumulator; update() returns how many whole steps of stepHours are due.
+// The simulation advances only in whole steps, so results do not depend on
+// how often the caller is scheduled. The time is computed from the count of
+// steps, not summed up, so it does not depend on how the steps were grouped
+// either, and a run replays bit for bit from the same step counts.
+class SimulationClock
+{
+public:
+	SimulationClock(double stepHours, double hoursPerSecond);
+
+	// feed real elapsed seconds, returns the number of fixed steps to run
+	int update(double realSeconds);
+
+	double getTime() const { return start + ticks * stepHours; } // simulated hours
+	void setTime(double hours) { setTime(hours, 0); }
+	// steps since the time was last set; with the time it was set to, the whole simulated time
+	void setTime(double hours, long long ticks) { start = hours; this->ticks = ticks; accumulator = 0; }
+	double getStartTime() const { return start; }
+	long long getTicks() const { return ticks; }
+	// steps without real time, e.g. to replay a recorded run
+	void advance(long long steps) { ticks += steps; }
+	double getStep() const { return stepHours; }
+	// fraction of a step left in the accumulator, for interpolation
+	double getAlpha() const { return accumulator / stepHours; }
+
+	void setWarp(double warp) { this->warp = warp; }
+	double getWarp() const { return warp; }
+	void setPaused(bool paused) { this->paused = paused; }
+	bool isPaused() const { return paused; }
+	void togglePause() { paused = !paused; }
+	// 0 means unlimited. Time beyond the limit is dropped, not deferred.
+	void setMaxSteps(int maxSteps) { this->maxSteps = maxSteps; }
+private:
+	double stepHours;
+	double hoursPerSecond;
+	double warp = 1.0;
+	bool paused = false;
+	int maxSteps = 0;
+	double start = 0; // hours
+	long long ticks = 0;
+	double accumulator = 0; // hours
+};
@@ -0,0 +1,57 @@
+#include <math.h>
+#include "SphereMesh.h"
+#include "FastMath.h"
+
+void SphereMesh::build(int slices, int stacks, float radius)
+{
+	this->slices = slices;
+	this->stacks = stacks;
+	vertices.resize((size_t)slices * getStripLength());
+	Vertex *v = vertices.empty() ? NULL : &vertices[0];
+	for (int s = 0; s != slices; ++s)
+	{
+		double theta[2] = { 2 * FastMath::PI * s / slices, 2 * FastMath::PI * (s + 1) / slices };
+		double sinTheta[2] = { sin(theta[0]), sin(theta[1]) };
+		double cosTheta[2] = { cos(theta[0]), cos(theta[1]) };
+		float u[2] = { (float)(1.0 - (double)s / slices), (float)(1.0 - (double)(s + 1) / slices) };
+
+		// north pole, then two vertices per ring, then south pole
+		for (int j = 0; j <= stacks; ++j)
+		{
+			double phi = FastMath::PI * j / stacks;
+			double sinPhi = sin(phi), cosPhi = cos(phi);
+			float t = (float)(1.0 - (double)j / stacks);
+			int count = (j == 0 || j == stacks) ? 1 : 2;
+			for (int k = 0; k != count; ++k, ++v)
+			{
+				v->normal[0] = (float)(sinPhi * cosTheta[k]);
+				v->normal[1] = (float)cosPhi;
+				v->normal[2] = (float)(sinPhi * sinTheta[k]);
+				if (count == 1)
+				{
+					v->normal[0] = v->normal[2] = 0;
+					v->normal[1] = j == 0 ? 1.0f : -1.0f;
+				}
+				for (int c = 0; c != 3; ++c)
+					v->position[c] = radius * v->normal[c];
+				v->texCoord[0] = u[k];
+				v->texCoord[1] = t;
+			}
+		}
+	}
+
+	// strip triangles, every other one flipped to keep the winding
+	indices.clear();
+	indices.reserve((size_t)slices * (getStripLength() - 2) * 3);
+	for (int s = 0; s != slices; ++s)
+	{
+		unsigned first = getStripFirst(s);
+		for (int k = 0; k + 2 < getStripLength(); ++k)
+		{
+			unsigned a = first + k, b = first + k + 1, c = first + k + 2;
+			indices.push_back(a);
+			indices.push_back(k % 2 ? c : b);
+			indices.push_back(k % 2 ? b : c);
+		}
+	}
+}
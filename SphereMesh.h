@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+// Latitude-longitude sphere as one triangle strip per slice, pole to pole.
+// Built once and drawn from client arrays instead of being tessellated with
+// sin/cos on every frame. Texture coordinates wrap once around the equator.
+// The same strips are also indexed as a triangle list, which can be drawn
+// in one call for any number of spheres.
+class SphereMesh
+{
+public:
+	struct Vertex
+	{
+		float position[3];
+		float normal[3];
+		float texCoord[2];
+	};
+
+	SphereMesh() {}
+	SphereMesh(int slices, int stacks, float radius = 1.0f) { build(slices, stacks, radius); }
+	void build(int slices, int stacks, float radius = 1.0f);
+
+	int getSlices() const { return slices; }
+	int getStacks() const { return stacks; }
+	// strip s covers getStripLength() vertices from getStripFirst(s)
+	int getStripFirst(int s) const { return s * getStripLength(); }
+	int getStripLength() const { return 2 * stacks; }
+	const std::vector<Vertex> &getVertices() const { return vertices; }
+	// three vertex indices per triangle
+	const std::vector<unsigned> &getIndices() const { return indices; }
+private:
+	int slices = 0;
+	int stacks = 0;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned> indices;
+};
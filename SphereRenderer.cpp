@@ -0,0 +1,374 @@
+#include <math.h>
+#include <stddef.h>
+#include "SphereRenderer.h"
+#include "FastMath.h"
+
+namespace
+{
+	// attribute locations
+	enum { POSITION, NORMAL, TEX_COORD, MODEL, LAYER = MODEL + 4, PLACEHOLDER };
+
+	const char *VERTEX_SHADER =
+		"#version 330 compatibility\n"
+		"in vec3 position;\n"
+		"in vec3 normal;\n"
+		"in vec2 texCoord;\n"
+		"in vec4 model0, model1, model2, model3;\n"
+		"in float layer;\n"
+		"in float placeholder;\n"
+		"uniform bool impostor;\n"
+		"out vec3 eyeNormal;\n"
+		"out vec3 uvw;\n"
+		"out float placeholderLayer;\n"
+		"out vec2 corner;\n"
+		"out mat3 toObject;\n"
+		"void main()\n"
+		"{\n"
+		"	mat4 modelView = gl_ModelViewMatrix * mat4(model0, model1, model2, model3);\n"
+		"	uvw = vec3(texCoord, layer);\n"
+		"	placeholderLayer = placeholder;\n"
+		"	corner = position.xy;\n"
+		"	if (impostor)\n"
+		"	{\n"
+		"		// quad facing the camera, as large as the sphere\n"
+		"		float radius = length(modelView[0].xyz);\n"
+		"		toObject = transpose(mat3(modelView)) / radius;\n"
+		"		eyeNormal = vec3(0.0, 0.0, 1.0);\n"
+		"		gl_Position = gl_ProjectionMatrix * (modelView[3] + vec4(position.xy * radius, 0.0, 0.0));\n"
+		"	}\n"
+		"	else\n"
+		"	{\n"
+		"		toObject = mat3(1.0);\n"
+		"		eyeNormal = mat3(modelView) * normal;\n"
+		"		gl_Position = gl_ProjectionMatrix * (modelView * vec4(position, 1.0));\n"
+		"	}\n"
+		"}\n";
+
+	// directional lights and a non-local viewer, as set up by the fixed-function code
+	const char *FRAGMENT_SHADER =
+		"#version 330 compatibility\n"
+		"uniform sampler2DArray textures;\n"
+		"uniform sampler2DArray placeholders;\n"
+		"uniform bool impostor;\n"
+		"in vec3 eyeNormal;\n"
+		"in vec3 uvw;\n"
+		"in float placeholderLayer;\n"
+		"in vec2 corner;\n"
+		"in mat3 toObject;\n"
+		"out vec4 color;\n"
+		"vec3 light(int i, vec3 n)\n"
+		"{\n"
+		"	vec3 l = normalize(gl_LightSource[i].position.xyz);\n"
+		"	vec3 h = normalize(l + vec3(0.0, 0.0, 1.0));\n"
+		"	float diffuse = max(dot(n, l), 0.0);\n"
+		"	float specular = diffuse > 0.0 ? pow(max(dot(n, h), 0.0), gl_FrontMaterial.shininess) : 0.0;\n"
+		"	return gl_FrontLightProduct[i].ambient.rgb + diffuse * gl_FrontLightProduct[i].diffuse.rgb\n"
+		"		+ specular * gl_FrontLightProduct[i].specular.rgb;\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 n = normalize(eyeNormal);\n"
+		"	vec3 coord = uvw;\n"
+		"	if (impostor)\n"
+		"	{\n"
+		"		// the sphere point under this pixel, textured like SphereMesh\n"
+		"		float r2 = dot(corner, corner);\n"
+		"		if (r2 > 1.0)\n"
+		"			discard;\n"
+		"		n = vec3(corner, sqrt(1.0 - r2));\n"
+		"		vec3 o = normalize(toObject * n);\n"
+		"		float theta = atan(o.z, o.x);\n"
+		"		if (theta < 0.0)\n"
+		"			theta += 6.28318531;\n"
+		"		coord.xy = vec2(1.0 - theta / 6.28318531, 1.0 - acos(clamp(o.y, -1.0, 1.0)) / 3.14159265);\n"
+		"	}\n"
+		"	vec3 lit = gl_FrontLightModelProduct.sceneColor.rgb + light(0, n) + light(1, n);\n"
+		"	vec4 texel = vec4(1.0);\n"
+		"	if (coord.z >= 0.0)\n"
+		"		texel = texture(textures, coord);\n"
+		"	else if (placeholderLayer >= 0.0)\n"
+		"		texel = texture(placeholders, vec3(coord.xy, placeholderLayer));\n"
+		"	color = vec4(clamp(lit, 0.0, 1.0), 1.0) * texel;\n"
+		"}\n";
+}
+
+GLuint SphereRenderer::compile(GLenum type, const char *source)
+{
+	GLuint shader = GLExt::CreateShader(type);
+	GLExt::ShaderSource(shader, 1, &source, NULL);
+	GLExt::CompileShader(shader);
+	GLint ok = 0;
+	GLExt::GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		GLExt::GetShaderInfoLog(shader, sizeof(log), NULL, log);
+		error = log;
+		GLExt::DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+bool SphereRenderer::initialize(const SphereMesh *levels, int count)
+{
+	release();
+	if (!GLExt::isLoaded() && !GLExt::load())
+	{
+		error = "OpenGL 3.3 is not available";
+		return false;
+	}
+	GLuint vertexShader = compile(GL_VERTEX_SHADER, VERTEX_SHADER);
+	GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		if (vertexShader != 0)
+			GLExt::DeleteShader(vertexShader);
+		if (fragmentShader != 0)
+			GLExt::DeleteShader(fragmentShader);
+		return false;
+	}
+	GLuint p = GLExt::CreateProgram();
+	GLExt::AttachShader(p, vertexShader);
+	GLExt::AttachShader(p, fragmentShader);
+	const char *ATTRIBUTES[] = { "position", "normal", "texCoord", "model0", "model1", "model2", "model3", "layer", "placeholder" };
+	for (GLuint a = 0; a != 9; ++a)
+		GLExt::BindAttribLocation(p, a, ATTRIBUTES[a]);
+	GLExt::LinkProgram(p);
+	GLExt::DeleteShader(vertexShader); // kept alive by the program
+	GLExt::DeleteShader(fragmentShader);
+	GLint ok = 0;
+	GLExt::GetProgramiv(p, GL_LINK_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		GLExt::GetProgramInfoLog(p, sizeof(log), NULL, log);
+		error = log;
+		GLExt::DeleteProgram(p);
+		return false;
+	}
+	program = p;
+	// the samplers never change units
+	GLExt::UseProgram(program);
+	GLExt::Uniform1i(GLExt::GetUniformLocation(program, "textures"), 0);
+	GLExt::Uniform1i(GLExt::GetUniformLocation(program, "placeholders"), 1);
+	GLExt::UseProgram(0);
+	impostorUniform = GLExt::GetUniformLocation(program, "impostor");
+
+	// every level in one pair of buffers, then the impostor quad
+	std::vector<SphereMesh::Vertex> vertices;
+	std::vector<unsigned> indices;
+	meshes.clear();
+	for (int level = 0; level != count; ++level)
+	{
+		const std::vector<SphereMesh::Vertex> &v = levels[level].getVertices();
+		const std::vector<unsigned> &i = levels[level].getIndices();
+		Mesh mesh = { (int)indices.size(), (int)i.size() };
+		meshes.push_back(mesh);
+		unsigned base = (unsigned)vertices.size();
+		vertices.insert(vertices.end(), v.begin(), v.end());
+		for (size_t k = 0; k != i.size(); ++k)
+			indices.push_back(base + i[k]);
+	}
+	unsigned base = (unsigned)vertices.size();
+	const float CORNERS[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+	for (int k = 0; k != 4; ++k)
+	{
+		SphereMesh::Vertex v = { { CORNERS[k][0], CORNERS[k][1], 0 }, { 0, 0, 1 }, { 0, 0 } };
+		vertices.push_back(v);
+	}
+	const unsigned QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+	impostor.firstIndex = (int)indices.size();
+	impostor.indexCount = 6;
+	for (int k = 0; k != 6; ++k)
+		indices.push_back(base + QUAD[k]);
+
+	GLExt::GenBuffers(1, &vertexBuffer);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLExt::BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SphereMesh::Vertex), &vertices[0], GL_STATIC_DRAW);
+	GLExt::GenBuffers(1, &indexBuffer);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	GLExt::BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), &indices[0], GL_STATIC_DRAW);
+	GLExt::GenBuffers(1, &instanceBuffer);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	instanceCapacity = 0;
+	return true;
+}
+
+void SphereRenderer::release()
+{
+	if (program == 0)
+		return;
+	GLExt::DeleteProgram(program);
+	GLExt::DeleteBuffers(1, &vertexBuffer);
+	GLExt::DeleteBuffers(1, &indexBuffer);
+	GLExt::DeleteBuffers(1, &instanceBuffer);
+	if (textures != 0)
+		glDeleteTextures(1, &textures);
+	if (placeholders != 0)
+		glDeleteTextures(1, &placeholders);
+	program = vertexBuffer = indexBuffer = instanceBuffer = textures = placeholders = 0;
+}
+
+void SphereRenderer::setTextureLayers(int width, int height, int layers, int levels)
+{
+	if (!isReady())
+		return;
+	if (textures == 0)
+		glGenTextures(1, &textures);
+	textureSize[0] = width;
+	textureSize[1] = height;
+	textureLayers = layers > 0 ? layers : 1;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textures);
+	for (int level = 0; level != levels; ++level)
+		GLExt::TexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB, levelSize(width, level), levelSize(height, level),
+			textureLayers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void SphereRenderer::setPlaceholders(int width, int height, int layers, const unsigned char *rgb)
+{
+	if (!isReady())
+		return;
+	if (placeholders == 0)
+		glGenTextures(1, &placeholders);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, placeholders);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLExt::TexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, width, height, layers > 0 ? layers : 1, 0,
+		GL_RGB, GL_UNSIGNED_BYTE, layers > 0 ? rgb : NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void SphereRenderer::setTextureLayer(int layer, const unsigned char *rgb, int level)
+{
+	if (textures == 0)
+		return;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textures);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLExt::TexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer,
+		levelSize(textureSize[0], level), levelSize(textureSize[1], level), 1, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void SphereRenderer::setTextureLevel(int level, const unsigned char *rgb)
+{
+	if (textures == 0)
+		return;
+	glBindTexture(GL_TEXTURE_2D_ARRAY, textures);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	GLExt::TexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+		levelSize(textureSize[0], level), levelSize(textureSize[1], level), textureLayers, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void SphereRenderer::setModel(Instance &instance, double x, double y, double z,
+	double revolution, double tilt, double rotation, double radius)
+{
+	double sr, cr, st, ct, so, co;
+	FastMath::sinCosDegree(revolution, sr, cr);
+	FastMath::sinCosDegree(tilt, st, ct);
+	FastMath::sinCosDegree(rotation, so, co);
+	// R = Ry(revolution) * Rz(tilt) * Ry(rotation), row major
+	double a[3][3] = { { cr * ct, -cr * st, sr }, { st, ct, 0 }, { -sr * ct, sr * st, cr } };
+	double b[3][3] = { { co, 0, so }, { 0, 1, 0 }, { -so, 0, co } };
+	float *m = instance.model;
+	for (int row = 0; row != 3; ++row)
+	{
+		for (int column = 0; column != 3; ++column)
+		{
+			double r = a[row][0] * b[0][column] + a[row][1] * b[1][column] + a[row][2] * b[2][column];
+			m[column * 4 + row] = (float)(r * radius);
+		}
+	}
+	m[3] = m[7] = m[11] = 0;
+	m[12] = (float)x;
+	m[13] = (float)y;
+	m[14] = (float)z;
+	m[15] = 1;
+}
+
+void SphereRenderer::draw(RenderState &state, const Instance *instances, const int *levels, int count)
+{
+	if (!isReady() || count <= 0)
+		return;
+
+	// counting sort by level, so each level is one contiguous range
+	int numLevels = getLevels();
+	levelStart.assign(numLevels + 1, 0);
+	for (int i = 0; i != count; ++i)
+		++levelStart[levels[i] + 1];
+	for (int level = 0; level != numLevels; ++level)
+		levelStart[level + 1] += levelStart[level];
+	sorted.resize(count);
+	levelFill.assign(levelStart.begin(), levelStart.end() - 1);
+	for (int i = 0; i != count; ++i)
+		sorted[levelFill[levels[i]]++] = instances[i];
+
+	// orphan the buffer so the driver does not wait on the previous frame
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	if (count > instanceCapacity)
+		instanceCapacity = count;
+	GLExt::BufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), NULL, GL_STREAM_DRAW);
+	GLExt::BufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Instance), &sorted[0]);
+	for (int a = MODEL; a <= PLACEHOLDER; ++a)
+	{
+		GLExt::VertexAttribDivisor(a, 1);
+		GLExt::EnableVertexAttribArray(a);
+	}
+
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLsizei stride = sizeof(SphereMesh::Vertex);
+	GLExt::VertexAttribPointer(POSITION, 3, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(SphereMesh::Vertex, position));
+	GLExt::VertexAttribPointer(NORMAL, 3, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(SphereMesh::Vertex, normal));
+	GLExt::VertexAttribPointer(TEX_COORD, 2, GL_FLOAT, GL_FALSE, stride, (const void *)offsetof(SphereMesh::Vertex, texCoord));
+	for (int a = POSITION; a <= TEX_COORD; ++a)
+		GLExt::EnableVertexAttribArray(a);
+
+	state.useProgram(program);
+	state.bindTexture(0, GL_TEXTURE_2D_ARRAY, textures);
+	state.bindTexture(1, GL_TEXTURE_2D_ARRAY, placeholders);
+
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (int level = 0; level != numLevels; ++level)
+	{
+		int first = levelStart[level], n = levelStart[level + 1] - first;
+		if (n == 0)
+			continue;
+		// no base instance before OpenGL 4.2: point the instance attributes at the range instead
+		size_t offset = first * sizeof(Instance);
+		for (int k = 0; k != 4; ++k)
+			GLExt::VertexAttribPointer(MODEL + k, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+				(const void *)(offset + offsetof(Instance, model) + 4 * k * sizeof(float)));
+		GLExt::VertexAttribPointer(LAYER, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			(const void *)(offset + offsetof(Instance, layer)));
+		GLExt::VertexAttribPointer(PLACEHOLDER, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+			(const void *)(offset + offsetof(Instance, placeholder)));
+		const Mesh &mesh = level < (int)meshes.size() ? meshes[level] : impostor;
+		GLExt::Uniform1i(impostorUniform, level == (int)meshes.size());
+		GLExt::DrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+			(const void *)(mesh.firstIndex * sizeof(unsigned)), n);
+		state.addDrawCalls(1);
+	}
+
+	// the program and the textures stay bound for the next frame; the
+	// attributes alias the fixed-function arrays and are reset
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+	for (int a = POSITION; a <= PLACEHOLDER; ++a)
+	{
+		GLExt::VertexAttribDivisor(a, 0);
+		GLExt::DisableVertexAttribArray(a);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "GLExtensions.h"
+#include "RenderState.h"
+#include "SphereMesh.h"
+
+// Draws every body with one instanced call per level of detail.
+// The unit spheres of every level live in vertex/index buffers built once;
+// each instance carries its model matrix (position, orientation and radius)
+// and a layer of one array texture holding the resident body textures, plus
+// a layer of a small always-resident placeholder array. The shader
+// reproduces the fixed-function lighting from the current light and material
+// state (GLSL 330 compatibility), so the rest of the scene is unchanged.
+// The level after the last mesh is an impostor: a camera-facing quad that
+// the fragment shader shades as a sphere, for bodies a few pixels across.
+class SphereRenderer
+{
+public:
+	struct Instance
+	{
+		float model[16]; // column major
+		float layer; // texture layer, -1 when not resident
+		float placeholder; // placeholder layer, used while layer is -1; -1 for an untextured body
+	};
+
+	SphereRenderer() {}
+	~SphereRenderer() { release(); }
+
+	// needs a current context. false if OpenGL 3.3 is missing; draw nothing then.
+	// levels[0] is the finest mesh.
+	bool initialize(const SphereMesh *levels, int count);
+	// meshes plus the impostor
+	int getLevels() const { return (int)meshes.size() + 1; }
+	bool isReady() const { return program != 0; }
+	const std::string &getError() const { return error; }
+	void release();
+
+	// every layer is width x height RGB at level 0, rows tightly packed; each level halves the size
+	void setTextureLayers(int width, int height, int layers, int levels = 1);
+	void setTextureLayer(int layer, const unsigned char *rgb, int level = 0);
+	// every layer of one level at once, layer after layer
+	void setTextureLevel(int level, const unsigned char *rgb);
+	// low resolution versions of every texture, layer after layer
+	void setPlaceholders(int width, int height, int layers, const unsigned char *rgb);
+
+	// translate, revolve about y, tilt about z, rotate about y, scale by radius; angles in degree
+	static void setModel(Instance &instance, double x, double y, double z,
+		double revolution, double tilt, double rotation, double radius);
+	// levels[i] is the level of instances[i]; binds the program and the
+	// textures through state and leaves them bound
+	void draw(RenderState &state, const Instance *instances, const int *levels, int count);
+private:
+	SphereRenderer(const SphereRenderer &);
+	SphereRenderer &operator=(const SphereRenderer &);
+
+	GLuint program = 0;
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLuint instanceBuffer = 0;
+	GLuint textures = 0;
+	GLuint placeholders = 0;
+	int textureSize[2] = { 0, 0 };
+	int textureLayers = 0;
+	GLint impostorUniform = -1;
+	struct Mesh
+	{
+		int firstIndex;
+		int indexCount;
+	};
+	std::vector<Mesh> meshes; // the impostor follows the last one
+	Mesh impostor;
+	int instanceCapacity = 0;
+	std::vector<Instance> sorted; // instances grouped by level
+	std::vector<int> levelStart;
+	std::vector<int> levelFill;
+	std::string error;
+
+	GLuint compile(GLenum type, const char *source);
+	static int levelSize(int size, int level) { return (size >> level) > 0 ? size >> level : 1; }
+};
@@ -0,0 +1,253 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "TextureCache.h"
+#include "BmpImage.h"
+
+namespace
+{
+	const size_t FIXED_HEADER = 4 + 5 * 4 + 8;
+
+	// bilinear, pixel centers aligned
+	void resize(const unsigned char *src, int sw, int sh, unsigned char *dst, int dw, int dh)
+	{
+		for (int y = 0; y != dh; ++y)
+		{
+			double fy = (y + 0.5) * sh / dh - 0.5;
+			int y0 = fy < 0 ? 0 : (int)fy;
+			int y1 = y0 + 1 < sh ? y0 + 1 : sh - 1;
+			double ty = fy < 0 ? 0 : fy - y0;
+			for (int x = 0; x != dw; ++x)
+			{
+				double fx = (x + 0.5) * sw / dw - 0.5;
+				int x0 = fx < 0 ? 0 : (int)fx;
+				int x1 = x0 + 1 < sw ? x0 + 1 : sw - 1;
+				double tx = fx < 0 ? 0 : fx - x0;
+				for (int c = 0; c != 3; ++c)
+				{
+					double top = src[(y0 * sw + x0) * 3 + c] * (1 - tx) + src[(y0 * sw + x1) * 3 + c] * tx;
+					double bottom = src[(y1 * sw + x0) * 3 + c] * (1 - tx) + src[(y1 * sw + x1) * 3 + c] * tx;
+					dst[(y * dw + x) * 3 + c] = (unsigned char)(top * (1 - ty) + bottom * ty + 0.5);
+				}
+			}
+		}
+	}
+
+	// 2x2 box filter to the next mip level
+	void halve(const unsigned char *src, int sw, int sh, unsigned char *dst, int dw, int dh)
+	{
+		for (int y = 0; y != dh; ++y)
+		{
+			int y0 = 2 * y < sh ? 2 * y : sh - 1, y1 = 2 * y + 1 < sh ? 2 * y + 1 : sh - 1;
+			for (int x = 0; x != dw; ++x)
+			{
+				int x0 = 2 * x < sw ? 2 * x : sw - 1, x1 = 2 * x + 1 < sw ? 2 * x + 1 : sw - 1;
+				for (int c = 0; c != 3; ++c)
+				{
+					int sum = src[(y0 * sw + x0) * 3 + c] + src[(y0 * sw + x1) * 3 + c]
+						+ src[(y1 * sw + x0) * 3 + c] + src[(y1 * sw + x1) * 3 + c];
+					dst[(y * dw + x) * 3 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	template <typename T> void put(std::vector<unsigned char> &out, T value)
+	{
+		out.insert(out.end(), (const unsigned char *)&value, (const unsigned char *)&value + sizeof(value));
+	}
+
+	template <typename T> T get(const unsigned char *&p)
+	{
+		T value;
+		memcpy(&value, p, sizeof(value));
+		p += sizeof(value);
+		return value;
+	}
+}
+
+int TextureCache::countLevels(int width, int height)
+{
+	int n = 1;
+	while ((width >> n) > 0 || (height >> n) > 0)
+		++n;
+	return n;
+}
+
+bool TextureCache::sourceInfo(const char *path, long long &size, long long &time)
+{
+	struct stat info;
+	if (stat(path, &info) != 0)
+	{
+		size = -1;
+		time = 0;
+		return false;
+	}
+	size = (long long)info.st_size;
+	time = (long long)info.st_mtime;
+	return true;
+}
+
+const unsigned char *TextureCache::getLevel(int level) const
+{
+	return file.getData() + levelOffset[level];
+}
+
+const unsigned char *TextureCache::getLayer(int level, int layer) const
+{
+	return getLevel(level) + (size_t)layer * getWidth(level) * getHeight(level) * 3;
+}
+
+bool TextureCache::open(const char *path, const std::vector<const char *> &sources, int width, int height)
+{
+	if (!file.open(path))
+	{
+		error = std::string(path) + ": cannot open";
+		return false;
+	}
+	const unsigned char *begin = file.getData(), *end = begin + file.getSize();
+	const unsigned char *p = begin;
+	bool ok = file.getSize() >= FIXED_HEADER && memcmp(p, "TXCH", 4) == 0;
+	if (ok)
+	{
+		p += 4;
+		ok = get<uint32_t>(p) == VERSION;
+		this->width = (int)get<uint32_t>(p);
+		this->height = (int)get<uint32_t>(p);
+		layers = (int)get<uint32_t>(p);
+		levels = (int)get<uint32_t>(p);
+		ok = ok && this->width == width && this->height == height && layers == (int)sources.size()
+			&& levels == countLevels(width, height);
+	}
+	uint64_t dataOffset = ok ? get<uint64_t>(p) : 0;
+
+	// stale if any source moved, changed or appeared
+	present.assign(layers > 0 && ok ? layers : 0, 0);
+	for (int i = 0; ok && i != layers; ++i)
+	{
+		if (end - p < 24)
+		{
+			ok = false;
+			break;
+		}
+		long long cachedSize = get<int64_t>(p), cachedTime = get<int64_t>(p);
+		uint32_t valid = get<uint32_t>(p);
+		uint32_t length = get<uint32_t>(p);
+		long long size, time;
+		sourceInfo(sources[i], size, time);
+		ok = (size_t)(end - p) >= length && length == strlen(sources[i]) && memcmp(p, sources[i], length) == 0
+			&& size == cachedSize && time == cachedTime;
+		p += length;
+		present[i] = valid != 0;
+	}
+
+	levelOffset.clear();
+	size_t offset = (size_t)dataOffset;
+	for (int level = 0; ok && level != levels; ++level)
+	{
+		levelOffset.push_back(offset);
+		offset += (size_t)layers * getWidth(level) * getHeight(level) * 3;
+	}
+	if (!ok || offset > file.getSize())
+	{
+		file.close();
+		error = std::string(path) + ": out of date";
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::build(const char *path, const std::vector<const char *> &sources, int width, int height, ThreadPool &pool)
+{
+	file.close();
+	int numLayers = (int)sources.size();
+	if (numLayers == 0)
+	{
+		error = "no textures";
+		return false;
+	}
+	int numLevels = countLevels(width, height);
+
+	std::vector<unsigned char> header;
+	header.insert(header.end(), "TXCH", "TXCH" + 4);
+	put<uint32_t>(header, VERSION);
+	put<uint32_t>(header, width);
+	put<uint32_t>(header, height);
+	put<uint32_t>(header, numLayers);
+	put<uint32_t>(header, numLevels);
+	put<uint64_t>(header, 0); // data offset, set below
+	for (int i = 0; i != numLayers; ++i)
+	{
+		long long size, time;
+		sourceInfo(sources[i], size, time);
+		put<int64_t>(header, size);
+		put<int64_t>(header, time);
+		put<uint32_t>(header, 0); // valid, set below
+		put<uint32_t>(header, (uint32_t)strlen(sources[i]));
+		header.insert(header.end(), sources[i], sources[i] + strlen(sources[i]));
+	}
+	header.resize((header.size() + 15) & ~(size_t)15, 0);
+	uint64_t dataOffset = header.size();
+	memcpy(&header[FIXED_HEADER - 8], &dataOffset, 8);
+
+	std::vector<size_t> offsets;
+	size_t total = 0;
+	for (int level = 0; level != numLevels; ++level)
+	{
+		offsets.push_back(total);
+		total += (size_t)numLayers * levelSize(width, level) * levelSize(height, level) * 3;
+	}
+	std::vector<unsigned char> pixels(total);
+	std::vector<char> decoded(numLayers, 0);
+
+	// each layer is independent: decode, rescale and build its mip chain on a worker
+	pool.parallelFor(numLayers, 1, [&](int begin, int end) {
+		BmpImage image;
+		for (int i = begin; i != end; ++i)
+		{
+			size_t layerSize = (size_t)width * height * 3;
+			unsigned char *base = &pixels[offsets[0] + i * layerSize];
+			decoded[i] = image.load(sources[i]);
+			if (!decoded[i])
+				memset(base, 128, layerSize);
+			else if (image.getWidth() == width && image.getHeight() == height)
+				memcpy(base, image.getPixels(), layerSize);
+			else
+				resize(image.getPixels(), image.getWidth(), image.getHeight(), base, width, height);
+			for (int level = 1; level != numLevels; ++level)
+			{
+				int sw = levelSize(width, level - 1), sh = levelSize(height, level - 1);
+				int dw = levelSize(width, level), dh = levelSize(height, level);
+				halve(&pixels[offsets[level - 1] + i * (size_t)sw * sh * 3], sw, sh,
+					&pixels[offsets[level] + i * (size_t)dw * dh * 3], dw, dh);
+			}
+		}
+	});
+	size_t at = FIXED_HEADER + 16;
+	for (int i = 0; i != numLayers; ++i)
+	{
+		uint32_t valid = decoded[i];
+		memcpy(&header[at], &valid, 4);
+		at += 24 + strlen(sources[i]);
+	}
+
+	std::string temporary = std::string(path) + ".tmp";
+	FILE *out = fopen(temporary.c_str(), "wb");
+	if (out == NULL)
+	{
+		error = temporary + ": cannot write";
+		return false;
+	}
+	bool written = fwrite(&header[0], 1, header.size(), out) == header.size()
+		&& fwrite(&pixels[0], 1, pixels.size(), out) == pixels.size();
+	written = fclose(out) == 0 && written;
+	remove(path);
+	if (!written || rename(temporary.c_str(), path) != 0)
+	{
+		remove(temporary.c_str());
+		error = std::string(path) + ": cannot write";
+		return false;
+	}
+	return open(path, sources, width, height);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+// Preprocessed textures: every source bitmap rescaled to one size with its
+// full mip chain, stored in one file that is memory-mapped at startup.
+// Level l holds all layers back to back, so a level of an array texture is
+// one upload straight from the mapping. The file remembers the size and
+// modification time of each source and is rebuilt when one changes.
+//
+// Layout (native byte order):
+//   "TXCH", uint32 version, uint32 width, height, layers, levels, uint64 dataOffset
+//   per layer: int64 sourceSize (-1 if missing), int64 sourceTime, uint32 valid, uint32 pathLength, path
+//   pixels at dataOffset: level 0 (all layers, RGB), level 1, ...
+class TextureCache
+{
+public:
+	static const unsigned VERSION = 1;
+
+	// true if the file exists and matches the sources and size
+	bool open(const char *path, const std::vector<const char *> &sources, int width, int height);
+	// decodes the sources on the pool, writes the file and opens it
+	bool build(const char *path, const std::vector<const char *> &sources, int width, int height, ThreadPool &pool);
+	const std::string &getError() const { return error; }
+
+	int getWidth(int level = 0) const { return levelSize(width, level); }
+	int getHeight(int level = 0) const { return levelSize(height, level); }
+	int getLayers() const { return layers; }
+	int getLevels() const { return levels; }
+	// false for a source that could not be decoded; its pixels are grey
+	bool hasLayer(int layer) const { return present[layer] != 0; }
+	// all layers of one level, RGB rows tightly packed
+	const unsigned char *getLevel(int level) const;
+	const unsigned char *getLayer(int level, int layer) const;
+private:
+	MappedFile file;
+	int width = 0;
+	int height = 0;
+	int layers = 0;
+	int levels = 0;
+	std::vector<char> present;
+	std::vector<size_t> levelOffset;
+	std::string error;
+
+	static int levelSize(int size, int level) { return (size >> level) > 0 ? size >> level : 1; }
+	static int countLevels(int width, int height);
+	static bool sourceInfo(const char *path, long long &size, long long &time);
+};
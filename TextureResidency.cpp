@@ -0,0 +1,79 @@
+#include <algorithm>
+#include "TextureResidency.h"
+
+void TextureResidency::reset(int textures, int slots)
+{
+	slotOf.assign(textures, -1);
+	textureIn.assign(slots, -1);
+	lastUsed.assign(slots, -1);
+	requested.assign(textures, 0);
+	requests.clear();
+	frame = 0;
+	Stats empty = { 0, slots, 0, 0, 0, 0 };
+	stats = empty;
+}
+
+void TextureResidency::beginFrame()
+{
+	++frame;
+	for (size_t i = 0; i != requests.size(); ++i)
+		requested[requests[i].texture] = 0;
+	requests.clear();
+}
+
+int TextureResidency::use(int texture, double priority)
+{
+	int slot = slotOf[texture];
+	if (slot >= 0)
+	{
+		lastUsed[slot] = frame;
+		return slot;
+	}
+	if (!requested[texture])
+	{
+		requested[texture] = 1;
+		Request request = { texture, priority };
+		requests.push_back(request);
+	}
+	return -1;
+}
+
+void TextureResidency::schedule(int maxLoads, std::vector<Load> &loads)
+{
+	loads.clear();
+	// largest on screen first
+	std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) {
+		return a.priority > b.priority;
+	});
+	for (size_t r = 0; r != requests.size() && (int)loads.size() < maxLoads; ++r)
+	{
+		int best = -1;
+		for (int s = 0; s != (int)textureIn.size(); ++s)
+		{
+			if (textureIn[s] < 0)
+			{
+				best = s;
+				break;
+			}
+			if (lastUsed[s] < frame && (best < 0 || lastUsed[s] < lastUsed[best]))
+				best = s;
+		}
+		if (best < 0)
+			break; // every slot is on screen
+		if (textureIn[best] >= 0)
+		{
+			slotOf[textureIn[best]] = -1;
+			++stats.evictions;
+		}
+		else
+			++stats.resident;
+		int texture = requests[r].texture;
+		textureIn[best] = texture;
+		slotOf[texture] = best;
+		lastUsed[best] = frame;
+		++stats.loads;
+		Load load = { texture, best };
+		loads.push_back(load);
+	}
+	stats.pending = (int)requests.size() - (int)loads.size();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+
+// Decides which textures occupy the slots of a fixed-size texture pool.
+// Each frame the renderer calls use() for every visible textured body; a
+// texture that is not resident is requested with a priority (its size on
+// screen). schedule() then hands out at most a few loads per frame, into
+// free slots first and otherwise into the least recently used slot that
+// was not needed this frame, so streaming never stalls a frame and a
+// visible texture is never evicted for another one.
+// The policy is GL-free; the caller uploads the pixels.
+class TextureResidency
+{
+public:
+	struct Load
+	{
+		int texture;
+		int slot;
+	};
+	struct Stats
+	{
+		int resident;
+		int slots;
+		int pending; // requested but not resident
+		long long loads;
+		long long evictions;
+		long long bytesUploaded;
+	};
+
+	void reset(int textures, int slots);
+	void beginFrame();
+	// slot of the texture, or -1 while it is not resident
+	int use(int texture, double priority);
+	void schedule(int maxLoads, std::vector<Load> &loads);
+	void addUploadedBytes(long long bytes) { stats.bytesUploaded += bytes; }
+	const Stats &getStats() const { return stats; }
+private:
+	struct Request
+	{
+		int texture;
+		double priority;
+	};
+	std::vector<int> slotOf; // by texture, -1 if not resident
+	std::vector<int> textureIn; // by slot, -1 if free
+	std::vector<long long> lastUsed; // by slot, frame number
+	std::vector<Request> requests;
+	std::vector<char> requested; // by texture, this frame
+	long long frame = 0;
+	Stats stats = { 0, 0, 0, 0, 0, 0 };
+};
@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads)
+	: pending(0), queued(0), nextQueue(0), stopping(false)
+{
+	if (threads <= 0)
+		threads = (int)std::thread::hardware_concurrency();
+	if (threads <= 0)
+		threads = 1;
+	for (int i = 0; i != threads; ++i)
+		queues.push_back(new Queue);
+	for (int i = 0; i != threads; ++i)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (size_t i = 0; i != workers.size(); ++i)
+		workers[i].join();
+	for (size_t i = 0; i != queues.size(); ++i)
+		delete queues[i];
+}
+
+void ThreadPool::submit(Task task)
+{
+	Queue &queue = *queues[nextQueue++ % queues.size()];
+	++pending;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	{
+		// sleepers test queued under the lock, so this wake-up cannot be lost
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		++queued;
+	}
+	wake.notify_all();
+}
+
+// runs one task from the home queue, or steals one. false if all are empty.
+bool ThreadPool::runOne(int home)
+{
+	Task task;
+	int n = (int)queues.size();
+	for (int k = 0; k != n && !task; ++k)
+	{
+		Queue &queue = *queues[(home + k) % n];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+			continue;
+		if (k == 0)
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+	--queued;
+	task();
+	if (--pending == 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wake.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+	for (;;)
+	{
+		if (runOne(index))
+			continue;
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return stopping || queued > 0; });
+		if (stopping)
+			return;
+	}
+}
+
+void ThreadPool::wait()
+{
+	int home = 0;
+	while (pending > 0)
+	{
+		if (runOne(home))
+			continue;
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return pending == 0 || queued > 0; });
+	}
+}
+
+void ThreadPool::parallelFor(int n, int grain, const std::function<void(int, int)> &body)
+{
+	if (n <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+	if (n <= grain || workers.size() == 1)
+	{
+		body(0, n);
+		return;
+	}
+	std::atomic<int> remaining((n + grain - 1) / grain);
+	for (int begin = 0; begin < n; begin += grain)
+	{
+		int end = begin + grain < n ? begin + grain : n;
+		submit([&body, &remaining, begin, end]() {
+			body(begin, end);
+			--remaining;
+		});
+	}
+	// help until our chunks are done, other tasks may run here too
+	int home = (int)(nextQueue % queues.size());
+	while (remaining > 0)
+		if (!runOne(home))
+			std::this_thread::yield();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it takes its own work from the back and, when
+// empty, steals from the front of the others. Threads that wait for work
+// (wait(), parallelFor()) run queued tasks instead of blocking, so pools
+// can be used from inside their own tasks.
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	// threads = 0 uses one worker per hardware thread
+	explicit ThreadPool(int threads = 0);
+	~ThreadPool();
+
+	int size() const { return (int)workers.size(); }
+	void submit(Task task);
+	// returns when every submitted task has finished
+	void wait();
+	// calls body(begin, end) for chunks of at most grain items covering [0, n)
+	void parallelFor(int n, int grain, const std::function<void(int, int)> &body);
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+	std::vector<std::thread> workers;
+	std::vector<Queue *> queues;
+	std::atomic<int> pending; // submitted but not finished
+	std::atomic<int> queued; // submitted but not started
+	std::atomic<unsigned> nextQueue;
+	std::atomic<bool> stopping;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	bool runOne(int home);
+	void workerLoop(int index);
+};
@@ -0,0 +1,192 @@
+#include "TrailRenderer.h"
+
+namespace
+{
+	// gl_VertexID is the index, sample * bodies + body, so the age of a
+	// vertex follows from its slot and the slot of the newest sample
+	const char *VERTEX_SHADER =
+		"#version 330 compatibility\n"
+		"in vec3 position;\n"
+		"uniform int bodies;\n"
+		"uniform int capacity;\n"
+		"uniform int newest;\n"
+		"out vec4 color;\n"
+		"void main()\n"
+		"{\n"
+		"	int age = (newest - gl_VertexID / bodies + capacity) % capacity;\n"
+		"	color = vec4(gl_Color.rgb, gl_Color.a * (1.0 - float(age) / float(capacity)));\n"
+		"	gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 1.0);\n"
+		"}\n";
+
+	const char *FRAGMENT_SHADER =
+		"#version 330 compatibility\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main()\n"
+		"{\n"
+		"	fragColor = color;\n"
+		"}\n";
+}
+
+GLuint TrailRenderer::compile(GLenum type, const char *source)
+{
+	GLuint shader = GLExt::CreateShader(type);
+	GLExt::ShaderSource(shader, 1, &source, NULL);
+	GLExt::CompileShader(shader);
+	GLint ok = 0;
+	GLExt::GetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		GLExt::GetShaderInfoLog(shader, sizeof(log), NULL, log);
+		error = log;
+		GLExt::DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+bool TrailRenderer::initialize(int bodyCount, int samples)
+{
+	release();
+	if (!GLExt::isLoaded() && !GLExt::load())
+	{
+		error = "OpenGL 3.3 is not available";
+		return false;
+	}
+	if (bodyCount <= 0 || samples < 2)
+	{
+		error = "no trails to draw";
+		return false;
+	}
+	GLuint vertexShader = compile(GL_VERTEX_SHADER, VERTEX_SHADER);
+	GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		if (vertexShader != 0)
+			GLExt::DeleteShader(vertexShader);
+		if (fragmentShader != 0)
+			GLExt::DeleteShader(fragmentShader);
+		return false;
+	}
+	GLuint p = GLExt::CreateProgram();
+	GLExt::AttachShader(p, vertexShader);
+	GLExt::AttachShader(p, fragmentShader);
+	GLExt::BindAttribLocation(p, 0, "position");
+	GLExt::LinkProgram(p);
+	GLExt::DeleteShader(vertexShader); // kept alive by the program
+	GLExt::DeleteShader(fragmentShader);
+	GLint ok = 0;
+	GLExt::GetProgramiv(p, GL_LINK_STATUS, &ok);
+	if (!ok)
+	{
+		char log[1024];
+		GLExt::GetProgramInfoLog(p, sizeof(log), NULL, log);
+		error = log;
+		GLExt::DeleteProgram(p);
+		return false;
+	}
+	program = p;
+	bodies = bodyCount;
+	capacity = samples;
+	GLExt::UseProgram(program);
+	GLExt::Uniform1i(GLExt::GetUniformLocation(program, "bodies"), bodies);
+	GLExt::Uniform1i(GLExt::GetUniformLocation(program, "capacity"), capacity);
+	newestUniform = GLExt::GetUniformLocation(program, "newest");
+	GLExt::UseProgram(0);
+
+	GLExt::GenBuffers(1, &vertexBuffer);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLExt::BufferData(GL_ARRAY_BUFFER, (GLsizeiptr)bodies * capacity * 3 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// body after body, its slots twice in a row
+	std::vector<GLuint> indices((size_t)bodies * 2 * capacity);
+	for (int body = 0; body != bodies; ++body)
+		for (int k = 0; k != 2 * capacity; ++k)
+			indices[(size_t)body * 2 * capacity + k] = (GLuint)((k % capacity) * bodies + body);
+	GLExt::GenBuffers(1, &indexBuffer);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	GLExt::BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	enabled.assign(bodies, 1);
+	staging.resize((size_t)bodies * 3);
+	clear();
+	return true;
+}
+
+void TrailRenderer::release()
+{
+	if (program == 0)
+		return;
+	GLExt::DeleteProgram(program);
+	GLExt::DeleteBuffers(1, &vertexBuffer);
+	GLExt::DeleteBuffers(1, &indexBuffer);
+	program = vertexBuffer = indexBuffer = 0;
+}
+
+void TrailRenderer::setColor(float r, float g, float b, float a)
+{
+	color[0] = r;
+	color[1] = g;
+	color[2] = b;
+	color[3] = a;
+}
+
+void TrailRenderer::append(const double *x, const double *y, const double *z)
+{
+	if (!isReady())
+		return;
+	for (int body = 0; body != bodies; ++body)
+	{
+		staging[3 * body] = (float)x[body];
+		staging[3 * body + 1] = (float)y[body];
+		staging[3 * body + 2] = (float)z[body];
+	}
+	size_t sampleBytes = staging.size() * sizeof(float);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLExt::BufferSubData(GL_ARRAY_BUFFER, head * sampleBytes, sampleBytes, &staging[0]);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+	head = (head + 1) % capacity;
+	if (count < capacity)
+		++count;
+}
+
+void TrailRenderer::draw(RenderState &state)
+{
+	if (!isReady() || count < 2)
+		return;
+	int oldest = (head - count + capacity) % capacity;
+	drawCounts.clear();
+	drawOffsets.clear();
+	for (int body = 0; body != bodies; ++body)
+	{
+		if (!enabled[body])
+			continue;
+		drawCounts.push_back(count);
+		drawOffsets.push_back((const void *)(((size_t)body * 2 * capacity + oldest) * sizeof(GLuint)));
+	}
+	if (drawCounts.empty())
+		return;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+	glColor4fv(color);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE); // behind the spheres, but not hiding each other
+	state.useProgram(program);
+	GLExt::Uniform1i(newestUniform, (head - 1 + capacity) % capacity);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	GLExt::VertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), NULL);
+	GLExt::EnableVertexAttribArray(0);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	GLExt::MultiDrawElements(GL_LINE_STRIP, &drawCounts[0], GL_UNSIGNED_INT, &drawOffsets[0], (GLsizei)drawCounts.size());
+	state.addDrawCalls(1);
+	GLExt::DisableVertexAttribArray(0);
+	GLExt::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	GLExt::BindBuffer(GL_ARRAY_BUFFER, 0);
+	glPopAttrib();
+}
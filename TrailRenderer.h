@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "GLExtensions.h"
+#include "RenderState.h"
+
+// The recent path of every body, as a line fading out with age. All bodies
+// are sampled together, so the history is one ring of samples in one vertex
+// buffer, laid out sample-major: a new sample of every body is a single
+// contiguous upload, and nothing older is touched again. A static index
+// buffer lists each body's slots twice over, so its path from the oldest
+// sample to the newest is one contiguous index range whatever the ring's
+// position; every enabled body is then one range of a single
+// glMultiDrawElements call. Needs OpenGL 3.3; without it trails are off.
+class TrailRenderer
+{
+public:
+	TrailRenderer() {}
+	~TrailRenderer() { release(); }
+
+	// needs a current context; samples is the length of every path
+	bool initialize(int bodies, int samples);
+	bool isReady() const { return program != 0; }
+	const std::string &getError() const { return error; }
+	void release();
+
+	// forgets every path, e.g. when the bodies jump
+	void clear() { head = count = 0; }
+	// one position per body, scene units
+	void append(const double *x, const double *y, const double *z);
+	int getSamples() const { return count; }
+	// every body has a trail unless disabled; after initialize()
+	void setEnabled(int body, bool on) { enabled[body] = on; }
+	// of the newest sample; older ones fade out to transparent
+	void setColor(float r, float g, float b, float a);
+
+	// with the current modelview and projection
+	void draw(RenderState &state);
+private:
+	TrailRenderer(const TrailRenderer &);
+	TrailRenderer &operator=(const TrailRenderer &);
+
+	GLuint compile(GLenum type, const char *source);
+
+	GLuint program = 0;
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLint newestUniform = -1;
+	int bodies = 0;
+	int capacity = 0; // samples per body
+	int head = 0; // slot of the next sample
+	int count = 0; // samples held, up to capacity
+	std::vector<char> enabled;
+	std::vector<float> staging; // one sample of every body
+	std::vector<GLsizei> drawCounts;
+	std::vector<const void *> drawOffsets;
+	float color[4] = { 1, 1, 1, 1 };
+	std::string error;
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+
+// Hands the newest of a stream of values from one writer thread to one
+// reader thread, without locks and without either side waiting. Of three
+// buffers the writer fills one, the reader holds one and the third is the
+// newest finished value; publish() and take() swap their own buffer with
+// that one in a single atomic exchange. Values the reader never took are
+// overwritten, so the reader always gets the latest complete one.
+template <class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : back(0), middle(1), front(2) {}
+
+	// writer: the buffer to fill, then publish() it
+	T &getBack() { return buffers[back]; }
+	void publish() { back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+	// reader: takes the newest value if one was published since the last take
+	bool hasNew() const { return (middle.load(std::memory_order_relaxed) & FRESH) != 0; }
+	bool take()
+	{
+		if (!hasNew())
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	const T &getFront() const { return buffers[front]; }
+private:
+	TripleBuffer(const TripleBuffer &);
+	TripleBuffer &operator=(const TripleBuffer &);
+
+	static const int INDEX = 3;
+	static const int FRESH = 4; // set on the middle index by publish()
+
+	T buffers[3];
+	int back; // writer only
+	std::atomic<int> middle;
+	int front; // reader only
+};
@@ -0,0 +1,154 @@
+// Searches a time range for alignments of catalog bodies as seen from an
+// observer: conjunctions, oppositions and the eclipses among them.
+//
+//   alignments [options] start end
+//     start, end         hours since the catalog epoch
+//     -c file            catalog (default solar_system.catalog)
+//     -b name,name,...   bodies, every pair of them is searched (default Sun,Moon)
+//     -o name            observer (default Earth)
+//     -s hours           scan step (default a 32nd of the shortest period involved)
+//     -e                 only events with an eclipse, transit or occultation
+//     -t threads         worker threads (default one per hardware thread)
+//     --close            close distances instead of real ones
+//
+// The events are written as CSV to standard output, in time order:
+//   hours,event,a,b,separation(degree),eclipse
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AlignmentSearch.h"
+#include "BodyCatalog.h"
+
+namespace
+{
+	int usage()
+	{
+		fprintf(stderr, "usage: alignments [-c catalog] [-b bodies] [-o observer] [-s hours] [-e] [-t threads] [--close] start end\n");
+		return 2;
+	}
+
+	bool parseNumber(const char *text, double &value)
+	{
+		char *end;
+		value = strtod(text, &end);
+		return end != text && *end == 0 && isfinite(value);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *catalogPath = "solar_system.catalog";
+	const char *bodyList = "Sun,Moon";
+	const char *observerName = "Earth";
+	double step = 0;
+	bool eclipsesOnly = false;
+	int threads = 0;
+	bool realDistance = true;
+	std::vector<double> range;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char *arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "-c") == 0 && hasValue)
+			catalogPath = argv[++a];
+		else if (strcmp(arg, "-b") == 0 && hasValue)
+			bodyList = argv[++a];
+		else if (strcmp(arg, "-o") == 0 && hasValue)
+			observerName = argv[++a];
+		else if (strcmp(arg, "-s") == 0 && hasValue)
+		{
+			if (!parseNumber(argv[++a], step) || step <= 0)
+				return usage();
+		}
+		else if (strcmp(arg, "-e") == 0)
+			eclipsesOnly = true;
+		else if (strcmp(arg, "-t") == 0 && hasValue)
+			threads = atoi(argv[++a]);
+		else if (strcmp(arg, "--close") == 0)
+			realDistance = false;
+		else
+		{
+			double value;
+			if (!parseNumber(arg, value))
+				return usage();
+			range.push_back(value);
+		}
+	}
+	if (range.size() != 2 || range[1] < range[0])
+		return usage();
+
+	BodyStore store;
+	BodyCatalog catalog;
+	if (!catalog.load(catalogPath, store))
+	{
+		fprintf(stderr, "%s\n", catalog.getError().c_str());
+		return 1;
+	}
+	store.setRealDistanceMode(realDistance);
+
+	int observer = catalog.find(observerName);
+	if (observer < 0)
+	{
+		fprintf(stderr, "%s: no body named '%s'\n", catalogPath, observerName);
+		return 1;
+	}
+	std::vector<int> bodies;
+	std::string list = bodyList;
+	for (size_t begin = 0; begin <= list.size();)
+	{
+		size_t end = list.find(',', begin);
+		if (end == std::string::npos)
+			end = list.size();
+		std::string name = list.substr(begin, end - begin);
+		int i = catalog.find(name.c_str());
+		if (i < 0)
+		{
+			fprintf(stderr, "%s: no body named '%s'\n", catalogPath, name.c_str());
+			return 1;
+		}
+		if (i == observer)
+		{
+			fprintf(stderr, "%s is the observer\n", name.c_str());
+			return 1;
+		}
+		bodies.push_back(i);
+		begin = end + 1;
+	}
+	if (bodies.size() < 2)
+		return usage();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	ThreadPool pool(threads);
+	AlignmentSearch search(store, observer, bodies);
+	if (step > 0)
+		search.setStep(step);
+	std::vector<AlignmentSearch::Event> events;
+	search.search(range[0], range[1], pool, events);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	printf("hours,event,a,b,separation,eclipse\n");
+	int shown = 0;
+	for (size_t k = 0; k != events.size(); ++k)
+	{
+		const AlignmentSearch::Event &event = events[k];
+		if (eclipsesOnly && !event.eclipse)
+			continue;
+		printf("%.4f,%s,%s,%s,%.5f,%d\n", event.hours, event.kind == AlignmentSearch::CONJUNCTION ? "conjunction" : "opposition",
+			catalog.getName(event.a), catalog.getName(event.b), event.separation, event.eclipse ? 1 : 0);
+		++shown;
+	}
+	if (fflush(stdout) != 0)
+	{
+		fprintf(stderr, "alignments: write failed\n");
+		return 1;
+	}
+	fprintf(stderr, "%d events, step %.3g h, %lld positions in %.1f ms\n", shown, search.getStep(),
+		search.getEvaluations(), ms);
+	return 0;
+}
@@ -0,0 +1,445 @@
+// Microbenchmarks for the simulation and rendering hot paths.
+//
+//   bench [-j file] [-f filter] [-r repetitions] [-m milliseconds]
+//     -j file    also write the results as JSON ("-" for standard output)
+//     -f text    only run benchmarks whose name contains text
+//     -r n       timed repetitions per benchmark, the median is reported (default 7)
+//     -m ms      minimum duration of one repetition (default 100)
+//
+// Every benchmark is calibrated to a fixed iteration count first, so all
+// repetitions time the same work. Compare runs on the same machine only.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "AlignmentSearch.h"
+#include "BmpImage.h"
+#include "BodyCatalog.h"
+#include "BodyPicker.h"
+#include "BodyStore.h"
+#include "Checkpoint.h"
+#include "EphemerisGenerator.h"
+#include "EphemerisTable.h"
+#include "Simulation.h"
+#include "SphereMesh.h"
+
+namespace
+{
+	struct Result
+	{
+		std::string name;
+		double nsPerOp;
+		double itemsPerOp;
+		long long iterations;
+	};
+
+	std::vector<Result> results;
+	const char *filter = NULL;
+	int repetitions = 7;
+	double minSeconds = 0.1;
+	volatile double sink; // keeps results alive
+
+	double seconds(const std::function<void()> &op, long long iterations)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (long long k = 0; k != iterations; ++k)
+			op();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// op does itemsPerOp units of work, e.g. one call per body
+	void run(const std::string &name, double itemsPerOp, const std::function<void()> &op)
+	{
+		if (filter != NULL && name.find(filter) == std::string::npos)
+			return;
+		long long iterations = 1;
+		while (seconds(op, iterations) < minSeconds)
+			iterations *= 2;
+
+		std::vector<double> ns;
+		for (int r = 0; r != repetitions; ++r)
+			ns.push_back(seconds(op, iterations) * 1e9 / iterations);
+		std::sort(ns.begin(), ns.end());
+
+		Result result = { name, ns[ns.size() / 2], itemsPerOp, iterations };
+		results.push_back(result);
+		printf("%-36s %14.1f ns/op %14.0f items/s\n", name.c_str(), result.nsPerOp,
+			itemsPerOp * 1e9 / result.nsPerOp);
+		fflush(stdout);
+	}
+
+	// n bodies in chains of the given depth below one root
+	void buildChains(BodyStore &store, int n, int depth)
+	{
+		store.reserve(n);
+		int root = store.add(696342, 0, 0, 609.12, 0, 7.25, -1);
+		store.setRealDistanceMode(root, true);
+		int p = root;
+		for (int i = 1; i < n; ++i)
+		{
+			int level = (i - 1) % depth;
+			int q = store.add(1000 + i % 5000, 1e6 + 10 * i, 1e4 + i, 24 + i % 100, 200 + i % 7000,
+				i % 30, level == 0 ? root : p);
+			store.setRealDistanceMode(q, true);
+			p = q;
+		}
+	}
+
+	void benchBodies()
+	{
+		const int SIZES[] = { 10, 1000, 100000 };
+		for (int s = 0; s != 3; ++s)
+		{
+			int n = SIZES[s];
+			BodyStore store;
+			buildChains(store, n, 2);
+			char name[64];
+			sprintf(name, "increaseRotation/%d", n);
+			run(name, n, [&]() {
+				for (int i = 0; i != n; ++i)
+					store.increaseRotation(i);
+			});
+			sprintf(name, "increaseRevolution/%d", n);
+			run(name, n, [&]() {
+				for (int i = 0; i != n; ++i)
+					store.increaseRevolution(i);
+			});
+			sprintf(name, "advance/%d", n);
+			run(name, n, [&]() { store.advance(); });
+			sink = store.angleRotation[n - 1] + store.angleRevolution[n - 1];
+		}
+	}
+
+	void benchWorldPositions()
+	{
+		const int N = 4096;
+		const int DEPTHS[] = { 1, 4, 16, 64 };
+		for (int d = 0; d != 4; ++d)
+		{
+			BodyStore store;
+			buildChains(store, N, DEPTHS[d]);
+			char name[64];
+			// every position is invalidated, as after a tick
+			sprintf(name, "getXYZ/dirty/depth%d", DEPTHS[d]);
+			run(name, N, [&]() {
+				store.markAllDirty();
+				double sum = 0;
+				for (int i = 0; i != N; ++i)
+					sum += store.getX(i) + store.getY(i) + store.getZ(i);
+				sink = sum;
+			});
+			sprintf(name, "getXYZ/clean/depth%d", DEPTHS[d]);
+			run(name, N, [&]() {
+				double sum = 0;
+				for (int i = 0; i != N; ++i)
+					sum += store.getX(i) + store.getY(i) + store.getZ(i);
+				sink = sum;
+			});
+		}
+	}
+
+	// the simulated state in gravity mode, the largest there is
+	void benchCheckpoint()
+	{
+		const int SIZES[] = { 10, 1000 };
+		ThreadPool pool;
+		for (int s = 0; s != 2; ++s)
+		{
+			int n = SIZES[s];
+			Simulation simulation(pool);
+			buildChains(simulation.getStore(), n, 2);
+			simulation.reset();
+			simulation.setDistanceMode(Simulation::GRAVITY);
+			Checkpoint checkpoint;
+			char name[64];
+			sprintf(name, "checkpointSave/%d", n);
+			run(name, n, [&]() {
+				checkpoint.begin(n);
+				simulation.save(checkpoint);
+			});
+			sprintf(name, "checkpointRestore/%d", n);
+			run(name, n, [&]() {
+				checkpoint.beginRead(n);
+				simulation.restore(checkpoint);
+			});
+			sink = (double)checkpoint.getData().size();
+		}
+	}
+
+	// every body at scattered times: the closed form against a table lookup.
+	// The Kepler orbits of this model are cheap, so for every body at once the
+	// table is about as fast; it only saves work on lookups of a single body.
+	void benchEphemeris()
+	{
+		const int N = 1000;
+		const int SEGMENTS = 64;
+		const double SEGMENT_HOURS = 192;
+		const char *PATH = "bench_ephemeris.tmp";
+		BodyStore store;
+		buildChains(store, N, 2);
+		std::vector<int> bodies;
+		std::vector<std::string> names;
+		std::vector<const char *> namePointers;
+		for (int i = 0; i != store.size(); ++i)
+		{
+			bodies.push_back(i);
+			names.push_back("body" + std::to_string(i));
+		}
+		for (size_t i = 0; i != names.size(); ++i)
+			namePointers.push_back(names[i].c_str());
+		ThreadPool pool;
+		EphemerisGenerator generator(store, bodies);
+		FILE *file = fopen(PATH, "wb");
+		bool written = file != NULL && EphemerisTable::writeHeader(file, namePointers, 0, SEGMENT_HOURS, SEGMENTS, 12)
+			&& generator.fit(0, SEGMENT_HOURS, SEGMENTS, 12, pool, file);
+		if (file != NULL)
+			written = fclose(file) == 0 && written;
+		EphemerisTable table;
+		if (!written || !table.open(PATH))
+		{
+			remove(PATH);
+			return;
+		}
+		int n = store.size();
+		double hours = 0;
+		run("ephemerisModel/1000", n, [&]() {
+			hours = fmod(hours + 977.3, SEGMENT_HOURS * SEGMENTS);
+			store.setEpoch(hours);
+			store.updateWorld();
+			sink = store.worldX[n - 1];
+		});
+		std::vector<double> x(n), y(n), z(n);
+		run("ephemerisTable/1000", n, [&]() {
+			hours = fmod(hours + 977.3, SEGMENT_HOURS * SEGMENTS);
+			table.positions(hours, &x[0], &y[0], &z[0]);
+			sink = x[n - 1];
+		});
+		// one body at a time; the model would have to compute all of them
+		int body = 0;
+		run("ephemerisLookup/1", 1, [&]() {
+			hours = fmod(hours + 977.3, SEGMENT_HOURS * SEGMENTS);
+			body = (body + 397) % n;
+			double px, py, pz;
+			table.position(body, hours, px, py, pz);
+			sink = px + py + pz;
+		});
+		table.close();
+		remove(PATH);
+	}
+
+	// rays from above the plane of the orbits towards bodies, half of them just missing
+	void benchPicking()
+	{
+		const int N = 300000;
+		const int RAYS = 1024;
+		BodyStore store;
+		buildChains(store, N, 2);
+		store.updateWorld();
+		BodyPicker picker;
+		picker.refit(store);
+		run("pickRefit/300000", N, [&]() { picker.refit(store); });
+
+		double origin[3] = { 0, 0, 0 };
+		for (int i = 0; i != N; ++i)
+			origin[1] = std::max(origin[1], fabs(store.worldX[i]) + fabs(store.worldZ[i]));
+		std::vector<double> rays;
+		for (int r = 0; r != RAYS; ++r)
+		{
+			int i = (int)((long long)r * 7919 % N);
+			double miss = r % 2 ? 3 * BodyStore::rescaleKm(store.radius[i]) : 0;
+			rays.push_back(store.worldX[i] + miss - origin[0]);
+			rays.push_back(store.worldY[i] - origin[1]);
+			rays.push_back(store.worldZ[i] - origin[2]);
+		}
+		int ray = 0, hits = 0;
+		run("pickRay/300000", 1, [&]() {
+			hits += picker.pick(origin, &rays[ray * 3], 0) >= 0;
+			ray = (ray + 1) % RAYS;
+		});
+		// every sphere against the ray, what the tree saves
+		run("pickLinear/300000", N, [&]() {
+			const double *d = &rays[ray * 3];
+			double length = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+			int best = -1;
+			double bestT = HUGE_VAL;
+			for (int i = 0; i != N; ++i)
+			{
+				double cx = store.worldX[i] - origin[0], cy = store.worldY[i] - origin[1], cz = store.worldZ[i] - origin[2];
+				double along = (cx * d[0] + cy * d[1] + cz * d[2]) / length;
+				double r = BodyStore::rescaleKm(store.radius[i]);
+				double off2 = cx * cx + cy * cy + cz * cz - along * along;
+				if (along > 0 && off2 <= r * r && along < bestT)
+				{
+					bestT = along;
+					best = i;
+				}
+			}
+			hits += best >= 0;
+			ray = (ray + 1) % RAYS;
+		});
+		sink = hits;
+	}
+
+	// a decade of Sun and Moon from the Earth, with the repo's catalog when run
+	// from the source directory: the search against stepping tick by tick
+	void benchAlignments()
+	{
+		const double DECADE = 87660;
+		BodyStore store;
+		BodyCatalog catalog;
+		if (!catalog.load("solar_system.catalog", store))
+			return;
+		store.setRealDistanceMode(true);
+		int earth = catalog.find("Earth"), sun = catalog.find("Sun"), moon = catalog.find("Moon");
+		if (earth < 0 || sun < 0 || moon < 0)
+			return;
+		std::vector<int> targets;
+		targets.push_back(sun);
+		targets.push_back(moon);
+		ThreadPool pool;
+		AlignmentSearch search(store, earth, targets);
+		std::vector<AlignmentSearch::Event> events;
+		run("alignmentSearch/decade", 1, [&]() {
+			search.search(0, DECADE, pool, events);
+			sink = (double)events.size();
+		});
+		// sign changes of the longitude difference only, without refining them
+		double hoursPerTick = store.getHoursPerTick();
+		run("alignmentTicks/decade", 1, [&]() {
+			int changes = 0;
+			double previous = 0;
+			for (double hours = 0; hours <= DECADE; hours += hoursPerTick)
+			{
+				store.setEpoch(hours);
+				store.updateWorld();
+				double ax = store.worldX[sun] - store.worldX[earth], az = store.worldZ[sun] - store.worldZ[earth];
+				double bx = store.worldX[moon] - store.worldX[earth], bz = store.worldZ[moon] - store.worldZ[earth];
+				double sine = bx * az - bz * ax;
+				changes += hours > 0 && (sine < 0) != (previous < 0);
+				previous = sine;
+			}
+			sink = changes;
+		});
+	}
+
+	void benchTessellation()
+	{
+		const int SIZES[][2] = { { 36, 18 }, { 128, 64 } };
+		for (int s = 0; s != 2; ++s)
+		{
+			SphereMesh mesh;
+			char name[64];
+			sprintf(name, "sphereMesh/%dx%d", SIZES[s][0], SIZES[s][1]);
+			double vertices = (double)SIZES[s][0] * 2 * SIZES[s][1];
+			run(name, vertices, [&]() {
+				mesh.build(SIZES[s][0], SIZES[s][1], 1.5f);
+				sink = mesh.getVertices().back().position[1];
+			});
+		}
+	}
+
+	// uncompressed 24-bit bitmap of the given size
+	std::vector<unsigned char> makeBitmap(int width, int height)
+	{
+		int stride = (width * 3 + 3) & ~3;
+		unsigned size = 54 + stride * height;
+		std::vector<unsigned char> data(size, 0);
+		data[0] = 'B'; data[1] = 'M';
+		// little-endian fields: file size, pixel offset, header size, width, height
+		const int OFFSETS[] = { 2, 10, 14, 18, 22 };
+		const unsigned VALUES[] = { size, 54, 40, (unsigned)width, (unsigned)height };
+		for (int k = 0; k != 5; ++k)
+			for (int b = 0; b != 4; ++b)
+				data[OFFSETS[k] + b] = (unsigned char)(VALUES[k] >> (8 * b));
+		data[26] = 1; // planes
+		data[28] = 24; // bits per pixel
+		for (size_t i = 54; i != data.size(); ++i)
+			data[i] = (unsigned char)(i * 131);
+		return data;
+	}
+
+	void benchBitmap()
+	{
+		BmpImage image;
+		std::vector<unsigned char> data = makeBitmap(1024, 512);
+		run("bmpDecode/memory/1024x512", 1024.0 * 512, [&]() {
+			image.decode(&data[0], data.size());
+			sink = image.getPixels()[0];
+		});
+		// the repo's own textures, when run from the source directory
+		if (image.load("texture_jupiter.bmp"))
+		{
+			double pixels = (double)image.getWidth() * image.getHeight();
+			run("bmpDecode/file/texture_jupiter.bmp", pixels, [&]() {
+				image.load("texture_jupiter.bmp");
+				sink = image.getPixels()[0];
+			});
+		}
+	}
+
+	void writeJson(FILE *file)
+	{
+		fprintf(file, "{\n  \"repetitions\": %d,\n  \"benchmarks\": [\n", repetitions);
+		for (size_t i = 0; i != results.size(); ++i)
+		{
+			const Result &r = results[i];
+			fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"items_per_op\": %.0f, "
+				"\"items_per_second\": %.1f, \"iterations\": %lld }%s\n",
+				r.name.c_str(), r.nsPerOp, r.itemsPerOp, r.itemsPerOp * 1e9 / r.nsPerOp, r.iterations,
+				i + 1 == results.size() ? "" : ",");
+		}
+		fprintf(file, "  ]\n}\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *jsonPath = NULL;
+	for (int a = 1; a < argc; ++a)
+	{
+		bool hasValue = a + 1 < argc;
+		if (strcmp(argv[a], "-j") == 0 && hasValue)
+			jsonPath = argv[++a];
+		else if (strcmp(argv[a], "-f") == 0 && hasValue)
+			filter = argv[++a];
+		else if (strcmp(argv[a], "-r") == 0 && hasValue)
+			repetitions = std::max(1, atoi(argv[++a]));
+		else if (strcmp(argv[a], "-m") == 0 && hasValue)
+			minSeconds = atof(argv[++a]) / 1000.0;
+		else
+		{
+			fprintf(stderr, "usage: bench [-j file] [-f filter] [-r repetitions] [-m milliseconds]\n");
+			return 2;
+		}
+	}
+
+	benchBodies();
+	benchWorldPositions();
+	benchCheckpoint();
+	benchEphemeris();
+	benchPicking();
+	benchAlignments();
+	benchTessellation();
+	benchBitmap();
+
+	if (jsonPath != NULL)
+	{
+		bool toStdout = strcmp(jsonPath, "-") == 0;
+		FILE *file = toStdout ? stdout : fopen(jsonPath, "w");
+		if (file == NULL)
+		{
+			perror(jsonPath);
+			return 1;
+		}
+		writeJson(file);
+		if (!toStdout)
+			fclose(file);
+	}
+	return 0;
+}
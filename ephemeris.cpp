@@ -0,0 +1,216 @@
+// Headless ephemeris generator: samples the catalog bodies over a time range.
+//
+//   ephemeris [options] start end step
+//     start, end, step   hours since the catalog epoch, end inclusive
+//     -c file            catalog (default solar_system.catalog)
+//     -b name,name,...   bodies to sample (default all)
+//     -f bin|csv|cheb    output format (default bin, see EphemerisWriter.h); cheb writes
+//                        an EphemerisTable with segments of step hours, to a file
+//     -d degree          of the Chebyshev series (default 12)
+//     -o file            output file (default standard output)
+//     -t threads         worker threads (default one per hardware thread)
+//     -n samples         times per work chunk (default 1024)
+//     --close            close distances instead of real ones
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "BodyCatalog.h"
+#include "EphemerisGenerator.h"
+#include "EphemerisTable.h"
+
+namespace
+{
+	int usage()
+	{
+		fprintf(stderr, "usage: ephemeris [-c catalog] [-b bodies] [-f bin|csv|cheb] [-d degree] [-o file] [-t threads] [-n samples] [--close] start end step\n");
+		return 2;
+	}
+
+	bool parseNumber(const char *text, double &value)
+	{
+		char *end;
+		value = strtod(text, &end);
+		return end != text && *end == 0 && isfinite(value);
+	}
+
+	// the largest distance between the table and the model at evenly spread
+	// times, halfway between nodes where the error of a fit is largest
+	void checkTable(const char *path, BodyStore &store, const std::vector<int> &bodies)
+	{
+		const double KM_PER_UNIT = 1.0 / BodyStore::rescaleKm(1.0);
+		const int CHECKS = 10007;
+		EphemerisTable table;
+		if (!table.open(path))
+		{
+			fprintf(stderr, "%s\n", table.getError().c_str());
+			return;
+		}
+		double worst = 0;
+		int worstBody = 0;
+		for (int c = 0; c != CHECKS; ++c)
+		{
+			double hours = table.getStart() + (table.getEnd() - table.getStart()) * (c + 0.5) / CHECKS;
+			store.setEpoch(hours);
+			store.updateWorld();
+			for (size_t k = 0; k != bodies.size(); ++k)
+			{
+				double x, y, z;
+				if (!table.position((int)k, hours, x, y, z))
+					continue;
+				int i = bodies[k];
+				double dx = x - store.worldX[i] * KM_PER_UNIT, dy = y - store.worldY[i] * KM_PER_UNIT, dz = z - store.worldZ[i] * KM_PER_UNIT;
+				double error = sqrt(dx * dx + dy * dy + dz * dz);
+				if (error > worst)
+				{
+					worst = error;
+					worstBody = (int)k;
+				}
+			}
+		}
+		fprintf(stderr, "largest error %.3g km (%s) at %d times\n", worst, table.getName(worstBody), CHECKS);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *catalogPath = "solar_system.catalog";
+	const char *bodyList = NULL;
+	const char *outputPath = NULL;
+	EphemerisWriter::Format format = EphemerisWriter::BINARY;
+	int threads = 0;
+	int chunkSize = 1024;
+	int degree = 12;
+	bool table = false;
+	bool realDistance = true;
+	std::vector<double> range;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char *arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "-c") == 0 && hasValue)
+			catalogPath = argv[++a];
+		else if (strcmp(arg, "-b") == 0 && hasValue)
+			bodyList = argv[++a];
+		else if (strcmp(arg, "-o") == 0 && hasValue)
+			outputPath = argv[++a];
+		else if (strcmp(arg, "-t") == 0 && hasValue)
+			threads = atoi(argv[++a]);
+		else if (strcmp(arg, "-n") == 0 && hasValue)
+			chunkSize = atoi(argv[++a]);
+		else if (strcmp(arg, "-f") == 0 && hasValue)
+		{
+			const char *name = argv[++a];
+			if (strcmp(name, "bin") == 0)
+				format = EphemerisWriter::BINARY;
+			else if (strcmp(name, "csv") == 0)
+				format = EphemerisWriter::CSV;
+			else if (strcmp(name, "cheb") == 0)
+				table = true;
+			else
+				return usage();
+		}
+		else if (strcmp(arg, "-d") == 0 && hasValue)
+			degree = atoi(argv[++a]);
+		else if (strcmp(arg, "--close") == 0)
+			realDistance = false;
+		else
+		{
+			double value;
+			if (!parseNumber(arg, value))
+				return usage();
+			range.push_back(value);
+		}
+	}
+	if (range.size() != 3 || range[2] <= 0 || range[1] < range[0] || degree < 1 || degree > 62
+		|| (table && outputPath == NULL))
+		return usage();
+
+	BodyStore store;
+	BodyCatalog catalog;
+	if (!catalog.load(catalogPath, store))
+	{
+		fprintf(stderr, "%s\n", catalog.getError().c_str());
+		return 1;
+	}
+	store.setRealDistanceMode(realDistance);
+
+	std::vector<int> bodies;
+	std::vector<const char *> names;
+	if (bodyList == NULL)
+	{
+		for (int i = 0; i != catalog.size(); ++i)
+			bodies.push_back(i);
+	}
+	else
+	{
+		std::string list = bodyList;
+		for (size_t begin = 0; begin <= list.size();)
+		{
+			size_t end = list.find(',', begin);
+			if (end == std::string::npos)
+				end = list.size();
+			std::string name = list.substr(begin, end - begin);
+			int i = catalog.find(name.c_str());
+			if (i < 0)
+			{
+				fprintf(stderr, "%s: no body named '%s'\n", catalogPath, name.c_str());
+				return 1;
+			}
+			bodies.push_back(i);
+			begin = end + 1;
+		}
+	}
+	for (size_t k = 0; k != bodies.size(); ++k)
+		names.push_back(catalog.getName(bodies[k]));
+
+	FILE *file = stdout;
+	if (outputPath != NULL)
+	{
+		file = fopen(outputPath, format == EphemerisWriter::BINARY || table ? "wb" : "w");
+		if (file == NULL)
+		{
+			perror(outputPath);
+			return 1;
+		}
+	}
+
+	double start = range[0], step = range[2];
+	ThreadPool pool(threads);
+	EphemerisGenerator generator(store, bodies);
+	generator.setChunkSize(chunkSize);
+	bool failed;
+	if (table)
+	{
+		// whole segments, covering the end
+		long long segments = (long long)ceil((range[1] - start) / step - 1e-9);
+		if (segments < 1)
+			segments = 1;
+		failed = !EphemerisTable::writeHeader(file, names, start, step, segments, degree)
+			|| !generator.fit(start, step, segments, degree, pool, file) || ferror(file) != 0;
+	}
+	else
+	{
+		long long count = (long long)floor((range[1] - start) / step + 1e-9) + 1;
+		EphemerisWriter writer(file, format);
+		writer.writeHeader(names, start, step, count);
+		generator.run(start, step, count, pool, writer);
+		failed = writer.failed();
+	}
+	if (file != stdout)
+		failed = fclose(file) != 0 || failed;
+	else
+		failed = fflush(file) != 0 || failed;
+	if (failed)
+	{
+		fprintf(stderr, "ephemeris: write failed\n");
+		return 1;
+	}
+	if (table)
+		checkTable(outputPath, store, bodies);
+	return 0;
+}
@@ -0,0 +1,339 @@
+// Headless renderer: draws the scene offscreen through EGL, without a window
+// or display server (Mesa llvmpipe on a CPU-only machine works), and reports
+// the frame rate.
+//
+//   headless [options]
+//     -c file            catalog (default solar_system.catalog)
+//     -s WxH             frame size (default 800x800)
+//     -n frames          frames to render (default 300)
+//     -v name            body to look at (default the first)
+//     -w warp            simulation warp (default 1)
+//     -b MB              texture budget (default 64)
+//     -o file.ppm        write the last frame
+//     -e pattern         export every frame, e.g. frame_%05d.ppm, or - for a PPM stream
+//     -p trace.json      profile the frames: print the phase times, write a Chrome trace
+//     --close            close distances instead of real ones
+//     --threaded         simulate on a thread of its own in real time, interpolated
+//     -r fps             pace the frames to a rate, as the viewer does while animating
+//     -t samples         draw orbit trails of that many samples
+//     --replay file.rec  replay a recording of the viewer's input over the frames
+//     -k file.chk        write a checkpoint of the scene after the last frame
+//     -m X,Y             pick the body at that pixel of the last frame, as a click in the viewer
+//
+// Every frame advances the simulation by 1/60 s and waits for the frame
+// with glFinish(), so the times include the rendering itself. Exporting
+// skips the wait: reading back and writing overlap with the next frames,
+// and the frame rate is then the end-to-end one. A replay instead spreads
+// the simulation steps of the recording evenly over the frames.
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "FrameExporter.h"
+#include "FrameScheduler.h"
+#include "Scene.h"
+#include "SceneInput.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	const double FRAME_SECONDS = 1.0 / 60.0;
+
+	int usage()
+	{
+		fprintf(stderr, "usage: headless [-c catalog] [-s WxH] [-n frames] [-v body] [-w warp] [-b MB] [-o file.ppm] [-e pattern] [-p trace.json] [--close] [--threaded] [-r fps] [-t samples] [--replay file.rec] [-k file.chk] [-m X,Y]\n");
+		return 2;
+	}
+
+	// a pbuffer on the surfaceless platform if there is one, else on the default display
+	bool createContext(int width, int height)
+	{
+		EGLDisplay display = EGL_NO_DISPLAY;
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+		if (getPlatformDisplay != NULL)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+		{
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+			{
+				fprintf(stderr, "no EGL display\n");
+				return false;
+			}
+		}
+		const EGLint CONFIG[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24, EGL_NONE };
+		EGLConfig config;
+		EGLint configs = 0;
+		if (!eglChooseConfig(display, CONFIG, &config, 1, &configs) || configs == 0)
+		{
+			fprintf(stderr, "no EGL config for desktop OpenGL\n");
+			return false;
+		}
+		const EGLint SURFACE[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+		EGLSurface surface = eglCreatePbufferSurface(display, config, SURFACE);
+		eglBindAPI(EGL_OPENGL_API);
+		// the instanced renderer needs 3.3 with the compatibility profile; anything else gets the fallback
+		const EGLint CONTEXT[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT, EGL_NONE };
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, CONTEXT);
+		if (context == EGL_NO_CONTEXT)
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+		if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+		{
+			fprintf(stderr, "no EGL context (error 0x%x)\n", eglGetError());
+			return false;
+		}
+		return true;
+	}
+
+	bool writeFrame(const char *path, int width, int height)
+	{
+		std::vector<unsigned char> pixels((size_t)width * height * 3);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+		FILE *file = fopen(path, "wb");
+		if (file == NULL)
+			return false;
+		fprintf(file, "P6\n%d %d\n255\n", width, height);
+		for (int y = height - 1; y >= 0; --y) // bottom-up in OpenGL
+			fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, file);
+		return fclose(file) == 0;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *catalogPath = "solar_system.catalog";
+	const char *viewName = NULL;
+	const char *outputPath = NULL;
+	const char *exportPattern = NULL;
+	const char *tracePath = NULL;
+	int width = 800, height = 800;
+	int frames = 300;
+	int budget = 0;
+	double warp = 1;
+	bool realDistance = true;
+	bool threaded = false;
+	double pace = 0;
+	int trailLength = 0;
+	const char *replayPath = NULL;
+	const char *checkpointPath = NULL;
+	int pickX = -1, pickY = -1;
+
+	for (int a = 1; a < argc; ++a)
+	{
+		const char *arg = argv[a];
+		bool hasValue = a + 1 < argc;
+		if (strcmp(arg, "-c") == 0 && hasValue)
+			catalogPath = argv[++a];
+		else if (strcmp(arg, "-s") == 0 && hasValue)
+		{
+			if (sscanf(argv[++a], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+				return usage();
+		}
+		else if (strcmp(arg, "-n") == 0 && hasValue)
+			frames = atoi(argv[++a]);
+		else if (strcmp(arg, "-v") == 0 && hasValue)
+			viewName = argv[++a];
+		else if (strcmp(arg, "-w") == 0 && hasValue)
+			warp = atof(argv[++a]);
+		else if (strcmp(arg, "-b") == 0 && hasValue)
+			budget = atoi(argv[++a]);
+		else if (strcmp(arg, "-o") == 0 && hasValue)
+			outputPath = argv[++a];
+		else if (strcmp(arg, "-e") == 0 && hasValue)
+			exportPattern = argv[++a];
+		else if (strcmp(arg, "-p") == 0 && hasValue)
+			tracePath = argv[++a];
+		else if (strcmp(arg, "--close") == 0)
+			realDistance = false;
+		else if (strcmp(arg, "--threaded") == 0)
+			threaded = true;
+		else if (strcmp(arg, "-r") == 0 && hasValue)
+			pace = atof(argv[++a]);
+		else if (strcmp(arg, "-t") == 0 && hasValue)
+			trailLength = atoi(argv[++a]);
+		else if (strcmp(arg, "--replay") == 0 && hasValue)
+			replayPath = argv[++a];
+		else if (strcmp(arg, "-k") == 0 && hasValue)
+			checkpointPath = argv[++a];
+		else if (strcmp(arg, "-m") == 0 && hasValue)
+		{
+			if (sscanf(argv[++a], "%d,%d", &pickX, &pickY) != 2 || pickX < 0 || pickY < 0)
+				return usage();
+		}
+		else
+			return usage();
+	}
+	if (frames <= 0 || (replayPath != NULL && threaded))
+		return usage();
+	// the report goes to stderr when the frames stream to stdout
+	FILE *report = exportPattern != NULL && strcmp(exportPattern, "-") == 0 ? stderr : stdout;
+
+	ThreadPool pool;
+	Scene scene(pool);
+	if (budget > 0)
+		scene.setTextureBudget(budget);
+	if (!scene.load(catalogPath))
+	{
+		fprintf(stderr, "%s\n", scene.getError().c_str());
+		return 1;
+	}
+	if (viewName != NULL)
+	{
+		int body = scene.getCatalog().find(viewName);
+		if (body < 0)
+		{
+			fprintf(stderr, "unknown body '%s'\n", viewName);
+			return 1;
+		}
+		scene.setViewObject(body);
+	}
+	scene.getSimulation().setDistanceMode(realDistance ? Simulation::REAL_DISTANCE : Simulation::CLOSE_DISTANCE);
+	scene.getSimulation().setWarp(warp);
+	if (trailLength > 0)
+	{
+		scene.setTrailLength(trailLength);
+		scene.setTrails(true);
+	}
+	SceneInput input(scene);
+	long long replayStep = 0; // per frame
+	if (replayPath != NULL)
+	{
+		if (!input.loadReplay(replayPath))
+		{
+			fprintf(stderr, "%s\n", input.getError().c_str());
+			return 1;
+		}
+		replayStep = (input.getReplayEnd() - input.getReplayStart() + frames - 1) / frames;
+		fprintf(report, "replaying %d events over steps %lld to %lld\n",
+			input.getEventCount(), input.getReplayStart(), input.getReplayEnd());
+	}
+
+	if (!createContext(width, height))
+		return 1;
+	fprintf(report, "%s, %s\n", (const char *)glGetString(GL_RENDERER), (const char *)glGetString(GL_VERSION));
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	scene.initializeGraphics();
+	double setupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	fprintf(report, "setup %.1f ms (textures %s)\n", setupMs, scene.getTextureSource());
+
+	FrameExporter exporter;
+	if (exportPattern != NULL && !exporter.start(exportPattern, width, height))
+	{
+		fprintf(stderr, "%s\n", exporter.getError().c_str());
+		return 1;
+	}
+
+	Profiler &profiler = scene.getProfiler();
+	profiler.setEnabled(tracePath != NULL);
+	if (threaded)
+		scene.getSimulation().start();
+	FrameScheduler scheduler(pace);
+	scheduler.setAnimating(true);
+	std::vector<double> frameMs(frames);
+	start = std::chrono::steady_clock::now();
+	double cpuStart = FrameScheduler::processCpuSeconds();
+	for (int f = 0; f != frames; ++f)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(scheduler.getDelayMs()));
+		scheduler.frameStarted();
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		Profiler::Scope scope(profiler, "frame");
+		if (replayPath != NULL)
+			input.replay(replayStep);
+		else if (!threaded)
+			scene.update(FRAME_SECONDS);
+		scene.render(width, height);
+		if (exporter.isRunning())
+		{
+			Profiler::Scope exportScope(profiler, "export");
+			exporter.capture();
+		}
+		else
+		{
+			Profiler::Scope finishScope(profiler, "finish");
+			glFinish();
+		}
+		profiler.endFrame();
+		frameMs[f] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+	}
+	GLenum glError = glGetError();
+	exporter.finish();
+	if (checkpointPath != NULL)
+	{
+		Checkpoint checkpoint;
+		scene.saveCheckpoint(checkpoint);
+		if (!checkpoint.save(checkpointPath))
+			fprintf(stderr, "%s\n", checkpoint.getError().c_str());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double cpu = (FrameScheduler::processCpuSeconds() - cpuStart) / seconds;
+
+	std::vector<double> sorted(frameMs);
+	std::sort(sorted.begin(), sorted.end());
+	const FrustumCuller::Stats &culling = scene.getCullingStats();
+	const TextureResidency::Stats &residency = scene.getResidencyStats();
+	fprintf(report, "%d frames of %dx%d in %.2f s: %.1f fps, CPU %.0f%% of a core\n",
+		frames, width, height, seconds, frames / seconds, cpu * 100.0);
+	fprintf(report, "frame ms: min %.2f, median %.2f, 95%% %.2f, max %.2f\n",
+		sorted[0], sorted[frames / 2], sorted[frames * 95 / 100], sorted[frames - 1]);
+	fprintf(report, "last frame: drawn %d of %d bodies, textures %d/%d resident, %lld loads, %.1f MB uploaded\n",
+		culling.drawn, culling.tested, residency.resident, residency.slots, residency.loads,
+		residency.bytesUploaded / (1024.0 * 1024.0));
+	const RenderState::Stats &state = scene.getRenderStats();
+	fprintf(report, "last frame: %d state changes (programs %d, textures %d, materials %d, lights %d, enables %d, projections %d),"
+		" %d redundant ones skipped, %d draw calls\n",
+		scene.getStateChanges(), state.programs, state.textures, state.materials, state.lights, state.capabilities,
+		state.projections, state.skipped, state.drawCalls);
+	if (pickX >= 0)
+	{
+		// as a click of the viewer on the last frame
+		std::chrono::steady_clock::time_point pickStart = std::chrono::steady_clock::now();
+		int body = scene.pick(pickX, pickY);
+		double pickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pickStart).count();
+		fprintf(report, "pick at %d,%d: %s (%.3f ms)\n", pickX, pickY,
+			body >= 0 ? scene.getCatalog().getName(body) : "nothing", pickMs);
+	}
+	if (exportPattern != NULL)
+	{
+		FrameExporter::Stats exported = exporter.getStats();
+		fprintf(report, "exported %lld of %lld frames, %.1f fps end to end, %lld stalls waiting %.1f ms for the writer\n",
+			exported.written, exported.captured, exported.written / exported.seconds,
+			exported.stalls, exported.stallSeconds * 1000.0);
+		if (!exporter.getError().empty())
+			fprintf(stderr, "%s\n", exporter.getError().c_str());
+	}
+	if (tracePath != NULL)
+	{
+		glFinish();
+		profiler.endFrame(); // the last GPU queries
+		std::vector<Profiler::Summary> summaries;
+		profiler.summarize(seconds + 1.0, summaries);
+		fprintf(report, "phase                count    avg ms    max ms\n");
+		for (size_t s = 0; s != summaries.size(); ++s)
+			fprintf(report, "%-14s %s %8d %9.3f %9.3f\n", summaries[s].name,
+				summaries[s].kind == Profiler::GPU ? "gpu" : "cpu", summaries[s].count, summaries[s].averageMs, summaries[s].maxMs);
+		if (!profiler.writeTrace(tracePath))
+			fprintf(stderr, "cannot write %s\n", tracePath);
+	}
+	if (glError != GL_NO_ERROR)
+		fprintf(stderr, "OpenGL error 0x%x\n", glError);
+
+	if (outputPath != NULL && !writeFrame(outputPath, width, height))
+	{
+		fprintf(stderr, "cannot write %s\n", outputPath);
+		return 1;
+	}
+	return glError == GL_NO_ERROR ? 0 : 1;
+}